@@ -4,17 +4,22 @@ sleep 30
 # 配置文件路径和可执行文件路径
 CONFIG_FILE="$MODPATH/module_settings/suppress_config.json"
 PROCESS_MANAGER="$MODPATH/bin/process_manager-DeepSuppressor"
-JSON_PARSER="$MODPATH/bin/json_parser-DeepSuppressor"
+POLICY_FILE="$MODPATH/module_settings/policy.json"
 LOG_DIR="$MODPATH/logs"
 
 # 确保日志目录存在
 mkdir -p "$LOG_DIR" || { log_error "Failed to create log directory"; Aurora_abort "PRL" 1;}
 
-ARGS=$($JSON_PARSER "$CONFIG_FILE") || { log_error "Failed to parse JSON"; Aurora_abort "PRL" 1;}
-# 启动进程管理器
+[ -f "$CONFIG_FILE" ] || { log_error "Config file not found"; Aurora_abort "PRL" 1;}
+# 启动进程管理器（配置由进程管理器直接读取并缓存为二进制）
 if [ -x "$PROCESS_MANAGER" ]; then
-    $PROCESS_MANAGER -d $ARGS &
-    log_info "Process manager started with arguments: $ARGS"
+    # 可选的压制策略表，不存在时使用内置 balanced 策略
+    if [ -f "$POLICY_FILE" ]; then
+        $PROCESS_MANAGER -d --policy "$POLICY_FILE" --config "$CONFIG_FILE" &
+    else
+        $PROCESS_MANAGER -d --config "$CONFIG_FILE" &
+    fi
+    log_info "Process manager started with config: $CONFIG_FILE"
 else
     log_error "Process manager not found or not executable"
     Aurora_abort "PRL" 1
@@ -16,6 +16,50 @@
 #include <map>
 #include <algorithm>
 #include <set>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <sys/mman.h>
+#include <cerrno>
+#include <cstdio>
+#include <csignal>
+#include <cstring>
+#include <optional>
+#include <functional>
+#include <memory>
+#include <condition_variable>
+#include <dirent.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <linux/input.h>
+#include <sys/ioctl.h>
+#include <sys/inotify.h>
+#include <sys/wait.h>
+#include <spawn.h>
+#include <poll.h>
+#include <sys/resource.h>
+#include <sstream>
+#include <type_traits>
+#include <sched.h>
+#include <deque>
+#include <future>
+#include <sys/timerfd.h>
+#include <bit>
+#include <linux/bpf.h>
+
+extern char** environ;
+
+// 模块安装目录，日志、习惯数据与状态文件默认都位于其下
+inline constexpr const char* DEFAULT_MODULE_DIR = "/data/adb/modules/DeepSuppressor";
+
+#ifndef SYS_pidfd_open
+#define SYS_pidfd_open 434
+#endif
+#ifndef SYS_process_madvise
+#define SYS_process_madvise 440
+#endif
+#ifndef MADV_PAGEOUT
+#define MADV_PAGEOUT 21
+#endif
 
 class Logger {
 public:
@@ -39,6 +83,7 @@ private:
     static size_t current_log_size;
     static char time_buffer[32];
     static std::atomic<unsigned> message_count;
+    static std::string base_path;  // 日志文件路径（不含 .log 后缀）
 
     static const char* getLevelString(Level level) noexcept {
         static const char* const level_strings[] = {
@@ -48,7 +93,6 @@ private:
     }
 
     static void rotateLogFiles() {
-        std::string base_path = "/data/adb/modules/DeepSuppressor/logs/process_manager";
         std::string oldest = base_path + "." + std::to_string(MAX_LOG_FILES - 1) + ".log";
         unlink(oldest.c_str());
 
@@ -75,8 +119,7 @@ private:
         if (current_log_size > MAX_LOG_SIZE) {
             ::close(log_fd);
             rotateLogFiles();
-            log_fd = open("/data/adb/modules/DeepSuppressor/logs/process_manager.log",
-                O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            log_fd = open((base_path + ".log").c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
             if (log_fd == -1) return;
             current_log_size = total_size;
         }
@@ -91,13 +134,13 @@ private:
     }
 
 public:
-    static bool init() noexcept {
+    static bool init(const std::string& log_dir = std::string(DEFAULT_MODULE_DIR) + "/logs") noexcept {
         log_buffer.reserve(BUFFER_RESERVE_SIZE);
         message_count = 0;
         current_log_size = 0;
 
-        log_fd = open("/data/adb/modules/DeepSuppressor/logs/process_manager.log",
-            O_WRONLY | O_CREAT | O_APPEND, 0644);
+        base_path = log_dir + "/process_manager";
+        log_fd = open((base_path + ".log").c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
         if (log_fd == -1) return false;
 
         struct stat st;
@@ -155,6 +198,7 @@ std::chrono::steady_clock::time_point Logger::last_flush;
 size_t Logger::current_log_size = 0;
 char Logger::time_buffer[32];
 std::atomic<unsigned> Logger::message_count{ 0 };
+std::string Logger::base_path;
 
 // 获取当前日期（天数）
 inline int getCurrentDay() {
@@ -172,26 +216,556 @@ inline int getCurrentHour() {
     return tm_info->tm_hour;
 }
 
+// 获取本地时区下自1970-01-01起的天数（跨年连续，用于历史记录）
+inline int getCurrentEpochDay() {
+    time_t now = time(nullptr);
+    struct tm tm_info;
+    localtime_r(&now, &tm_info);
+    return static_cast<int>((now + tm_info.tm_gmtoff) / 86400);
+}
+
+// 1970-01-01 为周四；返回 0=周日 ... 6=周六
+inline int weekdayOfEpochDay(int day) {
+    return (day + 4) % 7;
+}
+
+// 基于 posix_spawn 的命令执行器：带超时，支持逐行匹配并在找到所需内容后提前终止子进程
+class CommandRunner {
+public:
+    // 逐行回调，返回 true 表示已拿到所需内容，停止读取并终止子进程
+    using LineMatcher = std::function<bool(std::string_view line)>;
+
+    static constexpr auto DEFAULT_TIMEOUT = std::chrono::seconds(10);
+
+    // 直接执行程序（按 PATH 查找），不经过 shell
+    static std::string run(const std::vector<std::string>& args,
+                           const LineMatcher& matcher = nullptr,
+                           std::chrono::milliseconds timeout = DEFAULT_TIMEOUT) {
+        std::vector<char*> argv;
+        for (const auto& arg : args) {
+            argv.push_back(const_cast<char*>(arg.c_str()));
+        }
+        argv.push_back(nullptr);
+        return spawnAndRead(argv.data(), matcher, timeout);
+    }
+
+    // 通过 shell 执行命令行
+    static std::string runShell(const std::string& command,
+                                const LineMatcher& matcher = nullptr,
+                                std::chrono::milliseconds timeout = DEFAULT_TIMEOUT) {
+        static const char* shell = access("/system/bin/sh", X_OK) == 0 ? "/system/bin/sh" : "/bin/sh";
+        char* argv[] = { const_cast<char*>(shell), const_cast<char*>("-c"),
+                         const_cast<char*>(command.c_str()), nullptr };
+        return spawnAndRead(argv, matcher, timeout);
+    }
+
+    // 匹配包含 marker 的行
+    static LineMatcher stopAfter(std::string marker) {
+        return [marker = std::move(marker)](std::string_view line) {
+            return line.find(marker) != std::string_view::npos;
+        };
+    }
+
+    static unsigned spawnCount() { return spawn_count; }
+    static unsigned timeoutCount() { return timeout_count; }
+
+private:
+    static constexpr size_t READ_BUFFER_SIZE = 16384;
+    static inline std::atomic<unsigned> spawn_count{ 0 };
+    static inline std::atomic<unsigned> timeout_count{ 0 };
+
+    static std::string spawnAndRead(char* const argv[], const LineMatcher& matcher,
+                                    std::chrono::milliseconds timeout) {
+        int pipe_fds[2];
+        if (pipe2(pipe_fds, O_CLOEXEC) == -1) {
+            Logger::log(Logger::Level::ERROR, std::format("Failed to create pipe for command: {}", argv[0]));
+            return "";
+        }
+
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_init(&actions);
+        posix_spawn_file_actions_adddup2(&actions, pipe_fds[1], STDOUT_FILENO);
+        posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, "/dev/null", O_WRONLY, 0);
+
+        // 子进程自成进程组，超时或提前结束时可一并终止 shell 管道中的所有进程
+        posix_spawnattr_t attr;
+        posix_spawnattr_init(&attr);
+        posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETPGROUP);
+        posix_spawnattr_setpgroup(&attr, 0);
+
+        pid_t pid;
+        int err = posix_spawnp(&pid, argv[0], &actions, &attr, argv, environ);
+        posix_spawn_file_actions_destroy(&actions);
+        posix_spawnattr_destroy(&attr);
+        ::close(pipe_fds[1]);
+        if (err != 0) {
+            ::close(pipe_fds[0]);
+            Logger::log(Logger::Level::ERROR, std::format("Failed to execute command: {}", commandLine(argv)));
+            return "";
+        }
+        spawn_count++;
+
+        // 读缓冲区在同一线程的多次调用间复用
+        thread_local std::vector<char> buffer(READ_BUFFER_SIZE);
+        std::string output;
+        size_t line_start = 0;
+        bool stop = false;
+        bool timed_out = false;
+        auto deadline = std::chrono::steady_clock::now() + timeout;
+
+        while (!stop) {
+            auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - std::chrono::steady_clock::now()).count();
+            if (remaining <= 0) {
+                timed_out = true;
+                break;
+            }
+
+            pollfd pfd{ pipe_fds[0], POLLIN, 0 };
+            int ready = poll(&pfd, 1, static_cast<int>(remaining));
+            if (ready == -1 && errno == EINTR) continue;
+            if (ready <= 0) {
+                timed_out = ready == 0;
+                break;
+            }
+
+            ssize_t bytes = read(pipe_fds[0], buffer.data(), buffer.size());
+            if (bytes == -1 && errno == EINTR) continue;
+            if (bytes <= 0) break;
+            output.append(buffer.data(), bytes);
+
+            if (matcher) {
+                size_t newline;
+                while (!stop && (newline = output.find('\n', line_start)) != std::string::npos) {
+                    stop = matcher(std::string_view(output).substr(line_start, newline - line_start));
+                    line_start = newline + 1;
+                }
+            }
+        }
+        ::close(pipe_fds[0]);
+
+        if (stop || timed_out) {
+            ::kill(-pid, SIGKILL);
+        }
+        int status;
+        while (waitpid(pid, &status, 0) == -1 && errno == EINTR) {}
+
+        if (timed_out) {
+            timeout_count++;
+            Logger::log(Logger::Level::WARN, std::format("Command timed out after {}ms: {}",
+                timeout.count(), commandLine(argv)));
+        }
+        return output;
+    }
+
+    // 以空格连接的完整命令行，用于日志
+    static std::string commandLine(char* const argv[]) {
+        std::string line = argv[0];
+        for (int i = 1; argv[i]; ++i) {
+            line += ' ';
+            line += argv[i];
+        }
+        return line;
+    }
+};
+
+// 读取 /proc、/sys 等小文件的完整内容，失败返回空字符串
+inline std::string readProcFile(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) return "";
+
+    std::string content;
+    char buffer[4096];
+    ssize_t bytes_read;
+    while ((bytes_read = read(fd, buffer, sizeof(buffer))) > 0) {
+        content.append(buffer, bytes_read);
+    }
+    ::close(fd);
+    return content;
+}
+
+// 系统探测与操作的统一入口：/proc、/sys、/dev 路径经 path() 映射到根目录，
+// 外部命令与发送信号经 run()/signal() 执行，可整体替换为夹具实现在普通 Linux 上回放
+class SystemProbe {
+public:
+    virtual ~SystemProbe() = default;
+
+    virtual const char* name() const = 0;
+    virtual bool signal(pid_t pid, int sig) = 0;
+    virtual bool setNice(pid_t pid, int nice_value) = 0;
+    // pid 是否对应本机真实进程，决定能否使用 pidfd/process_madvise 等直接作用于进程的系统调用
+    virtual bool hostPids() const = 0;
+
+    std::string run(const std::vector<std::string>& args, const CommandRunner::LineMatcher& matcher = nullptr,
+                    std::chrono::milliseconds timeout = CommandRunner::DEFAULT_TIMEOUT) {
+        return execute(args, matcher, timeout);
+    }
+
+    const std::string& root() const { return root_dir; }
+    std::string path(std::string absolute) const {
+        return root_dir.empty() ? absolute : root_dir + absolute;
+    }
+
+    static SystemProbe& current() { return *slot(); }
+    // 只应在启动其他线程之前调用
+    static void install(std::unique_ptr<SystemProbe> probe) { slot() = std::move(probe); }
+
+protected:
+    explicit SystemProbe(std::string root) : root_dir(std::move(root)) {}
+
+    virtual std::string execute(const std::vector<std::string>& args, const CommandRunner::LineMatcher& matcher,
+                                std::chrono::milliseconds timeout) = 0;
+
+private:
+    std::string root_dir;
+
+    static std::unique_ptr<SystemProbe>& slot();
+};
+
+// 真实设备：路径不变，直接执行命令和发送信号
+class DeviceSystemProbe : public SystemProbe {
+public:
+    DeviceSystemProbe() : SystemProbe("") {}
+
+    const char* name() const override { return "device"; }
+    bool signal(pid_t pid, int sig) override { return ::kill(pid, sig) == 0; }
+    bool setNice(pid_t pid, int nice_value) override { return setpriority(PRIO_PROCESS, pid, nice_value) == 0; }
+    bool hostPids() const override { return true; }
+
+protected:
+    std::string execute(const std::vector<std::string>& args, const CommandRunner::LineMatcher& matcher,
+                        std::chrono::milliseconds timeout) override {
+        return CommandRunner::run(args, matcher, timeout);
+    }
+};
+
+// 夹具回放：根目录下放置合成的 proc/、sys/、dev/ 树，命令输出取自 commands/ 下的录制文件
+// （参数以 '_' 连接，如 commands/dumpsys_window），每次调用重新读取，外部可随时改写。
+// 信号与优先级调整只追加到 actions.log；SIGKILL 额外把 proc/<pid> 改名为 proc/.killed-<pid>，使进程从扫描中消失
+class FixtureSystemProbe : public SystemProbe {
+public:
+    explicit FixtureSystemProbe(std::string root) : SystemProbe(std::move(root)) {}
+
+    const char* name() const override { return "fixture"; }
+
+    bool signal(pid_t pid, int sig) override {
+        bool exists = record(pid, std::format("signal {}", sig));
+        if (exists && sig == SIGKILL) {
+            std::string proc_dir = root() + "/proc/" + std::to_string(pid);
+            rename(proc_dir.c_str(), (root() + "/proc/.killed-" + std::to_string(pid)).c_str());
+        }
+        return exists;
+    }
+
+    bool setNice(pid_t pid, int nice_value) override { return record(pid, std::format("nice {}", nice_value)); }
+    bool hostPids() const override { return false; }
+
+protected:
+    std::string execute(const std::vector<std::string>& args, const CommandRunner::LineMatcher& matcher,
+                        std::chrono::milliseconds) override {
+        std::string file;
+        for (const auto& arg : args) {
+            if (!file.empty()) file += '_';
+            file += arg;
+        }
+        std::replace(file.begin(), file.end(), '/', '_');
+
+        std::string output = readProcFile(root() + "/commands/" + file);
+        if (!matcher) return output;
+        // 与真实执行一致：匹配到所需行后截断
+        size_t line_start = 0;
+        size_t newline;
+        while ((newline = output.find('\n', line_start)) != std::string::npos) {
+            bool stop = matcher(std::string_view(output).substr(line_start, newline - line_start));
+            line_start = newline + 1;
+            if (stop) {
+                output.resize(line_start);
+                break;
+            }
+        }
+        return output;
+    }
+
+private:
+    std::mutex actions_mutex;
+
+    // 追加一行 "<Unix秒> <pid> <动作>"，返回目标进程是否存在于夹具中
+    bool record(pid_t pid, const std::string& action) {
+        bool exists = access((root() + "/proc/" + std::to_string(pid)).c_str(), F_OK) == 0;
+        std::lock_guard<std::mutex> lock(actions_mutex);
+        if (FILE* log = fopen((root() + "/actions.log").c_str(), "ae")) {
+            fprintf(log, "%lld %d %s%s\n", static_cast<long long>(time(nullptr)), pid, action.c_str(), exists ? "" : " (missing)");
+            fclose(log);
+        }
+        return exists;
+    }
+};
+
+inline std::unique_ptr<SystemProbe>& SystemProbe::slot() {
+    static std::unique_ptr<SystemProbe> probe = std::make_unique<DeviceSystemProbe>();
+    return probe;
+}
+
+// 系统路径映射到当前探测根目录
+inline std::string sysPath(std::string absolute) {
+    return SystemProbe::current().path(std::move(absolute));
+}
+
+// /proc/<pid>/stat 中关心的字段
+struct ProcStat {
+    pid_t ppid{0};
+    unsigned long long utime{0};  // 用户态时间（clock ticks）
+    unsigned long long stime{0};  // 内核态时间（clock ticks）
+};
+
+inline bool readProcStat(pid_t pid, ProcStat& out) {
+    std::string content = readProcFile(sysPath("/proc/" + std::to_string(pid) + "/stat"));
+    // 进程名可能包含空格和括号，从最后一个 ')' 之后开始解析
+    size_t comm_end = content.rfind(')');
+    if (comm_end == std::string::npos) return false;
+
+    char state;
+    int ppid;
+    unsigned long long utime, stime;
+    int parsed = sscanf(content.c_str() + comm_end + 1,
+        " %c %d %*d %*d %*d %*d %*u %*u %*u %*u %*u %llu %llu",
+        &state, &ppid, &utime, &stime);
+    if (parsed != 4) return false;
+
+    out.ppid = ppid;
+    out.utime = utime;
+    out.stime = stime;
+    return true;
+}
+
+// 系统可用内存（/proc/meminfo 的 MemAvailable），失败返回 -1
+inline long long readMemAvailableBytes() {
+    std::string meminfo = readProcFile(sysPath("/proc/meminfo"));
+    size_t pos = meminfo.find("MemAvailable:");
+    if (pos == std::string::npos) return -1;
+    return strtoll(meminfo.c_str() + pos + 13, nullptr, 10) * 1024;
+}
+
+// 读取进程的真实 UID，失败返回 -1
+inline long readProcUid(pid_t pid) {
+    std::string status = readProcFile(sysPath("/proc/" + std::to_string(pid) + "/status"));
+    size_t pos = status.find("\nUid:");
+    if (pos == std::string::npos) return -1;
+    return strtol(status.c_str() + pos + 5, nullptr, 10);
+}
+
+// 汇总 /proc/net/dev 格式文件中除回环外所有接口的收发字节数
+inline bool readNetDevTotals(const std::string& path, unsigned long long& rx_bytes, unsigned long long& tx_bytes) {
+    std::string content = readProcFile(path);
+    if (content.empty()) return false;
+
+    rx_bytes = 0;
+    tx_bytes = 0;
+    size_t line_start = 0;
+    while (line_start < content.size()) {
+        size_t line_end = content.find('\n', line_start);
+        if (line_end == std::string::npos) line_end = content.size();
+        std::string line = content.substr(line_start, line_end - line_start);
+        line_start = line_end + 1;
+
+        // 接口行格式: "  wlan0: rx_bytes rx_packets ... (8列) tx_bytes ..."
+        size_t colon = line.find(':');
+        if (colon == std::string::npos) continue;
+        std::string iface = line.substr(0, colon);
+        iface.erase(0, iface.find_first_not_of(' '));
+        if (iface == "lo") continue;
+
+        unsigned long long rx, tx;
+        if (sscanf(line.c_str() + colon + 1, "%llu %*u %*u %*u %*u %*u %*u %*u %llu", &rx, &tx) == 2) {
+            rx_bytes += rx;
+            tx_bytes += tx;
+        }
+    }
+    return true;
+}
+
+// 读取进程所属的 cgroup v2 路径（如 /uid_10123/pid_4567），失败返回空字符串
+inline std::string getCgroupV2Path(pid_t pid) {
+    std::string cgroups = readProcFile(sysPath("/proc/" + std::to_string(pid) + "/cgroup"));
+    size_t pos = cgroups.find("0::");
+    if (pos == std::string::npos) return "";
+
+    size_t end = cgroups.find('\n', pos);
+    return cgroups.substr(pos + 3, end == std::string::npos ? std::string::npos : end - pos - 3);
+}
+
+// 单个应用最近30天的使用历史环：每天记录使用过的小时位图和前台分钟数。
+// 由此推导按星期×小时（7×24）的时间衰减使用概率。
+class UsageHistory {
+public:
+    static constexpr size_t DAYS = 30;
+    static constexpr double DECAY_DAYS = 10.0;  // 时间衰减常数
+    static constexpr double WEEKDAY_PRIOR = 1.0; // 同星期样本不足时向全局分布收缩的强度
+
+    struct DayRecord {
+        uint16_t day{ 0 };         // 纪元天数
+        uint16_t fg_minutes{ 0 };
+        uint32_t hour_mask{ 0 };   // 低24位：当天使用过的小时
+    };
+
+    bool empty() const { return size_ == 0; }
+    size_t size() const { return size_; }
+
+    void recordOpen(int day, int hour) {
+        current(day).hour_mask |= 1u << hour;
+    }
+
+    void recordForeground(int day, int seconds) {
+        auto& record = current(day);
+        record.fg_minutes = static_cast<uint16_t>(std::min(24 * 60, record.fg_minutes + seconds / 60));
+    }
+
+    // 给定星期与小时的使用概率 [0,1]；无历史时返回负值
+    double probability(int today, int weekday, int hour) const {
+        double weekday_hits = 0.0, weekday_weight = 0.0;
+        double all_hits = 0.0, all_weight = 0.0;
+        for (size_t i = 0; i < size_; ++i) {
+            const auto& record = records_[i];
+            int age = today - record.day;
+            if (age < 0 || age >= static_cast<int>(DAYS)) continue;
+            double weight = decayWeights()[age];
+            double hit = hourHit(record.hour_mask, hour);
+            all_hits += weight * hit;
+            all_weight += weight;
+            if (weekdayOfEpochDay(record.day) == weekday) {
+                weekday_hits += weight * hit;
+                weekday_weight += weight;
+            }
+        }
+        if (all_weight <= 0.0) return -1.0;
+        double overall = all_hits / all_weight;
+        return (weekday_hits + WEEKDAY_PRIOR * overall) / (weekday_weight + WEEKDAY_PRIOR);
+    }
+
+    // 差分编码：[首日, 位图, 分钟, 日差, 位图, 分钟, ...]，按日期升序
+    std::vector<uint32_t> encode() const {
+        std::vector<uint32_t> out;
+        out.reserve(size_ * 3);
+        int previous_day = 0;
+        for (size_t i = 0; i < size_; ++i) {
+            const auto& record = records_[(head_ + DAYS - size_ + i) % DAYS];
+            out.push_back(static_cast<uint32_t>(record.day - previous_day));
+            out.push_back(record.hour_mask);
+            out.push_back(record.fg_minutes);
+            previous_day = record.day;
+        }
+        return out;
+    }
+
+    // 合并另一份历史：本地已有的日期以本地为准，其余日期补入，保留最近 DAYS 天。
+    // 位图无法按权重缩放，先验只填补本地缺失的日期
+    void fillMissingDays(const UsageHistory& other) {
+        std::map<uint16_t, DayRecord> by_day;
+        for (size_t i = 0; i < other.size_; ++i) {
+            const auto& record = other.records_[i];
+            by_day[record.day] = record;
+        }
+        for (size_t i = 0; i < size_; ++i) {
+            const auto& record = records_[i];
+            by_day[record.day] = record;
+        }
+        size_ = 0;
+        head_ = 0;
+        size_t skip = by_day.size() > DAYS ? by_day.size() - DAYS : 0;
+        for (const auto& [day, record] : by_day) {
+            if (skip > 0) {
+                skip--;
+                continue;
+            }
+            push(record);
+        }
+    }
+
+    void decode(const std::vector<uint32_t>& data) {
+        size_ = 0;
+        head_ = 0;
+        uint32_t day = 0;
+        for (size_t i = 0; i + 2 < data.size(); i += 3) {
+            day += data[i];
+            DayRecord record;
+            record.day = static_cast<uint16_t>(day);
+            record.hour_mask = data[i + 1] & 0xFFFFFF;
+            record.fg_minutes = static_cast<uint16_t>(std::min<uint32_t>(data[i + 2], 24 * 60));
+            push(record);
+        }
+    }
+
+private:
+    std::array<DayRecord, DAYS> records_{};
+
+    // 按天龄的时间衰减权重 exp(-age / DECAY_DAYS)，只计算一次
+    static const std::array<double, DAYS>& decayWeights() {
+        static const std::array<double, DAYS> weights = [] {
+            std::array<double, DAYS> table{};
+            for (size_t age = 0; age < DAYS; ++age) {
+                table[age] = std::exp(-static_cast<double>(age) / DECAY_DAYS);
+            }
+            return table;
+        }();
+        return weights;
+    }
+    uint8_t head_{ 0 };  // 下一个写入位置
+    uint8_t size_{ 0 };
+
+    // 相邻小时按一半计入，平滑打开时间的抖动
+    static double hourHit(uint32_t mask, int hour) {
+        if (mask & (1u << hour)) return 1.0;
+        uint32_t neighbours = (hour > 0 ? 1u << (hour - 1) : 0) | (hour < 23 ? 1u << (hour + 1) : 0);
+        return (mask & neighbours) ? 0.5 : 0.0;
+    }
+
+    void push(const DayRecord& record) {
+        records_[head_] = record;
+        head_ = static_cast<uint8_t>((head_ + 1) % DAYS);
+        if (size_ < DAYS) size_++;
+    }
+
+    DayRecord& current(int day) {
+        if (size_ == 0 || records_[(head_ + DAYS - 1) % DAYS].day != day) {
+            DayRecord record;
+            record.day = static_cast<uint16_t>(day);
+            push(record);
+        }
+        return records_[(head_ + DAYS - 1) % DAYS];
+    }
+};
+
 struct AppStats {
-    int usage_count{ 0 };
-    int total_foreground_time{ 0 };
-    int total_background_time{ 0 };
-    int switch_count{ 0 };
-    double importance_weight{ 0.0 };
-    int last_usage_hour{ -1 };
-    int last_used_day{ -1 };
-    int consecutive_days_used{ 0 };
-    double usage_pattern_score{ 0.0 };
-    std::array<int, 24> hourly_usage{ 0 }; // 每小时使用情况
-    std::chrono::steady_clock::time_point last_foreground_time;
-    std::chrono::steady_clock::time_point last_background_time;
+    // 紧凑记录：字段按宽度排列，小时计数使用16位并每周整体减半，旧习惯逐渐淡出
+    static constexpr uint16_t HOURLY_USAGE_MAX = 0xFFFF;
+    static constexpr uint32_t HOURLY_DECAY_PERIOD_HOURS = 7 * 24;
+
+    uint32_t usage_count{ 0 };
+    uint32_t total_foreground_time{ 0 };
+    uint32_t total_background_time{ 0 };
+    uint32_t switch_count{ 0 };
+    uint32_t last_seen_hour{ 0 }; // 最近一次更新时的小时戳（Unix时间/3600），用于淘汰
+    uint32_t hourly_decay_hour{ 0 }; // 上次小时计数减半的小时戳，0 表示尚未开始计时
+    std::array<uint16_t, 24> hourly_usage{}; // 每小时使用情况（累计）
+    UsageHistory history; // 最近30天的逐日记录
+    int16_t last_used_day{ -1 };
+    uint16_t consecutive_days_used{ 0 };
+    int8_t last_usage_hour{ -1 };
+    bool dirty{ false }; // 自上次保存以来是否修改
+
+    // 增量维护的小时多样性：Σlog(usage + 1) 与活跃小时数
+    double hourly_log_sum{ 0.0 };
+    uint8_t active_hours{ 0 };
+
+    // 修改纪元：统计变化时递增，分数在读取时按需重算
+    uint32_t modified_epoch{ 1 };
 
     void updateForegroundTime(int duration, int hour) {
         total_foreground_time += duration;
         usage_count++;
         
         // 更新小时使用情况
-        hourly_usage[hour]++;
+        addHourlyUsage(hour);
         
         // 更新连续使用天数
         int current_day = getCurrentDay();
@@ -207,52 +781,138 @@ struct AppStats {
             last_used_day = current_day;
         }
         
-        last_usage_hour = hour;
-        updateUsagePatternScore();
+        last_usage_hour = static_cast<int8_t>(hour);
+        touch();
     }
 
     void updateBackgroundTime(int duration) {
         total_background_time += duration;
+        touch();
     }
 
-    void updateUsagePatternScore() {
-        // 更复杂的使用模式评分，考虑连续使用天数和小时分布
-        double hourly_diversity = 0.0;
-        int active_hours = 0;
-        
+    void touch() {
+        modified_epoch++;
+        dirty = true;
+    }
+
+    double usagePatternScore() const {
+        refreshScores();
+        return usage_pattern_score;
+    }
+
+    double importanceWeight() const {
+        refreshScores();
+        return importance_weight;
+    }
+
+    // 按权重叠加先验数据（先验计数视为伪计数）
+    void blend(const AppStats& prior, double weight) {
+        auto scaled = [weight](uint32_t value) { return static_cast<uint32_t>(std::lround(value * weight)); };
+        usage_count += scaled(prior.usage_count);
+        total_foreground_time += scaled(prior.total_foreground_time);
+        total_background_time += scaled(prior.total_background_time);
+        switch_count += scaled(prior.switch_count);
+        consecutive_days_used = static_cast<uint16_t>(std::max<uint32_t>(consecutive_days_used, scaled(prior.consecutive_days_used)));
+        if (last_usage_hour < 0) {
+            last_usage_hour = prior.last_usage_hour;
+        }
+        // 仅存在于先验中的应用不应因小时戳为0而最先被淘汰
+        last_seen_hour = std::max(last_seen_hour, prior.last_seen_hour);
+        history.fillMissingDays(prior.history);
+        for (size_t h = 0; h < hourly_usage.size(); ++h) {
+            hourly_usage[h] = static_cast<uint16_t>(std::min<uint32_t>(HOURLY_USAGE_MAX,
+                hourly_usage[h] + scaled(prior.hourly_usage[h])));
+        }
+        rebuildHourlyCache();
+    }
+
+    // 按小时戳补做错过的每周减半；返回计数是否变化
+    bool decayHourlyUsage(uint32_t now_hour) {
+        if (hourly_decay_hour == 0 || now_hour < hourly_decay_hour) {
+            hourly_decay_hour = now_hour;
+            return false;
+        }
+        uint32_t periods = (now_hour - hourly_decay_hour) / HOURLY_DECAY_PERIOD_HOURS;
+        if (periods == 0) return false;
+        hourly_decay_hour += periods * HOURLY_DECAY_PERIOD_HOURS;
+        int shift = static_cast<int>(std::min<uint32_t>(periods, 16));
+        for (auto& usage : hourly_usage) {
+            usage = static_cast<uint16_t>(usage >> shift);
+        }
+        rebuildHourlyCache();
+        return true;
+    }
+
+    // 从 hourly_usage 重建缓存（加载后调用）
+    void rebuildHourlyCache() {
+        hourly_log_sum = 0.0;
+        active_hours = 0;
         for (int usage : hourly_usage) {
             if (usage > 0) {
                 active_hours++;
-                hourly_diversity += std::log(usage + 1.0); // 使用对数避免单一时段过高权重
+                hourly_log_sum += logUsage(usage);
             }
         }
-        
-        // 归一化小时多样性
-        if (active_hours > 0) {
-            hourly_diversity /= active_hours;
+        touch();
+    }
+
+private:
+    mutable uint32_t score_epoch{ 0 };
+    mutable float importance_weight{ 0.0f };
+    mutable float usage_pattern_score{ 0.0f };
+
+    // log(count + 1)，小计数查表
+    static double logUsage(int count) {
+        static const auto table = [] {
+            std::array<double, 256> values{};
+            for (size_t i = 0; i < values.size(); ++i) {
+                values[i] = std::log(static_cast<double>(i) + 1.0);
+            }
+            return values;
+        }();
+        if (count >= 0 && count < static_cast<int>(table.size())) {
+            return table[count];
         }
-        
-        // 计算最终分数，考虑使用次数、前台时间、切换次数、连续使用天数和小时多样性
-        usage_pattern_score = 
+        return std::log(count + 1.0);
+    }
+
+    void addHourlyUsage(int hour) {
+        // 每周减半后实际不会饱和，仅防止溢出
+        if (hourly_usage[hour] == HOURLY_USAGE_MAX) return;
+        int previous = hourly_usage[hour]++;
+        if (previous == 0) {
+            active_hours++;
+        } else {
+            hourly_log_sum -= logUsage(previous);
+        }
+        hourly_log_sum += logUsage(previous + 1);
+    }
+
+    void refreshScores() const {
+        if (score_epoch == modified_epoch) return;
+        score_epoch = modified_epoch;
+
+        // 使用模式评分，考虑连续使用天数和小时分布（对数避免单一时段过高权重）
+        double hourly_diversity = active_hours > 0 ? hourly_log_sum / active_hours : 0.0;
+        double pattern_score = 
             (usage_count * 0.2) + 
             (total_foreground_time / 3600.0 * 0.3) + 
             (switch_count * 0.1) + 
             (consecutive_days_used * 0.2) + 
             (hourly_diversity * 0.2);
-    }
+        usage_pattern_score = static_cast<float>(pattern_score);
 
-    void updateImportanceWeight() {
-        // 更智能的重要性权重计算
+        // 重要性权重
         double recency_factor = last_usage_hour >= 0 ? 1.0 : 0.5; // 最近使用过的应用权重更高
         double consistency_factor = std::min(1.0, consecutive_days_used / 7.0); // 连续使用天数影响
         
-        importance_weight = 
-            (usage_pattern_score * 0.4) + 
+        double weight = 
+            (pattern_score * 0.4) + 
             (total_foreground_time / 3600.0 * 0.3) + 
             (recency_factor * 0.1) + 
             (consistency_factor * 0.2);
             
-        importance_weight = std::min(100.0, importance_weight);
+        importance_weight = static_cast<float>(std::min(100.0, weight));
     }
 };
 
@@ -267,12 +927,8 @@ struct TimePattern {
         activity_level = (activity_level * 0.8) + (activity * 0.2);
         check_frequency = static_cast<int>(check_frequency * 0.8 + freq * 0.2);
         
-        // 更新活跃应用列表
-        std::set<std::string> current_apps(apps.begin(), apps.end());
-        std::set<std::string> existing_apps(active_apps.begin(), active_apps.end());
-        
         // 合并应用列表，保留最活跃的应用（最多10个）
-        for (const auto& app : current_apps) {
+        for (const auto& app : apps) {
             if (std::find(active_apps.begin(), active_apps.end(), app) == active_apps.end()) {
                 active_apps.push_back(app);
             }
@@ -284,6 +940,156 @@ struct TimePattern {
         }
     }
 };
+// 下一个应用预测：对前台切换建立带衰减的一阶马尔可夫模型。
+// 同时记录跳过一步的转移（半权重），以越过桌面等中间应用。
+class NextAppPredictor {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr auto WINDOW = std::chrono::minutes(10); // 预测窗口：离开上一个应用后多久内算作转移
+    static constexpr double DECAY = 0.9;                     // 每次记录新转移时旧计数的衰减
+    static constexpr size_t MAX_SUCCESSORS = 16;
+    static constexpr size_t MAX_SOURCES = 200;
+    static constexpr double CONFIDENCE_SAMPLES = 5.0;        // 样本达到该量级时置信度约为0.5
+
+    struct Prediction {
+        double probability{ 0.0 }; // 转移概率
+        double confidence{ 0.0 };  // 当前来源的样本置信度 [0,1)
+    };
+
+    // 每个检查周期传入当前前台包名集合
+    void observe(const std::set<std::string>& foreground, Clock::time_point now) {
+        for (const auto& pkg : foreground) {
+            if (!current_.count(pkg)) {
+                entered(pkg, now);
+            }
+        }
+        if (!foreground.empty()) {
+            last_seen_ = now;
+        }
+        current_ = foreground;
+    }
+
+    // 在当前上下文下 package 成为下一个打开应用的概率
+    Prediction predict(const std::string& package, Clock::time_point now) const {
+        Prediction result;
+        if (last_app_.empty() || now - last_seen_ > WINDOW) {
+            return result;
+        }
+        auto it = sources_.find(last_app_);
+        if (it == sources_.end() || it->second.total <= 0.0) {
+            return result;
+        }
+        for (const auto& [next, count] : it->second.next) {
+            if (next == package) {
+                result.probability = count / it->second.total;
+                break;
+            }
+        }
+        result.confidence = it->second.total / (it->second.total + CONFIDENCE_SAMPLES);
+        return result;
+    }
+
+    nlohmann::json toJson() const {
+        nlohmann::json j = nlohmann::json::object();
+        for (const auto& [source, successors] : sources_) {
+            for (const auto& [next, count] : successors.next) {
+                j[source][next] = count;
+            }
+        }
+        return j;
+    }
+
+    void fromJson(const nlohmann::json& j) {
+        sources_.clear();
+        merge(j, 1.0);
+    }
+
+    // 按权重合并另一份转移表（用于导入先验）
+    void merge(const nlohmann::json& j, double weight) {
+        if (!j.is_object()) return;
+        for (const auto& [source, next_json] : j.items()) {
+            if (!next_json.is_object()) continue;
+            auto& successors = sources_[source];
+            for (const auto& [next, count_json] : next_json.items()) {
+                if (!count_json.is_number()) continue;
+                double count = count_json.get<double>() * weight;
+                auto it = std::find_if(successors.next.begin(), successors.next.end(),
+                    [&](const auto& entry) { return entry.first == next; });
+                if (it != successors.next.end()) {
+                    it->second += count;
+                } else if (successors.next.size() < MAX_SUCCESSORS) {
+                    successors.next.emplace_back(next, count);
+                } else {
+                    continue;
+                }
+                successors.total += count;
+            }
+        }
+    }
+
+private:
+    struct Successors {
+        double total{ 0.0 };
+        std::vector<std::pair<std::string, double>> next;
+    };
+
+    std::map<std::string, Successors> sources_;
+    std::set<std::string> current_;
+    std::string last_app_;
+    std::string previous_app_;
+    Clock::time_point last_seen_;
+
+    void entered(const std::string& package, Clock::time_point now) {
+        if (package == last_app_) return;
+        if (!last_app_.empty() && now - last_seen_ <= WINDOW) {
+            record(last_app_, package, 1.0);
+            if (!previous_app_.empty() && previous_app_ != package) {
+                record(previous_app_, package, 0.5);
+            }
+            previous_app_ = last_app_;
+        } else {
+            previous_app_.clear();
+        }
+        last_app_ = package;
+    }
+
+    void record(const std::string& source, const std::string& package, double weight) {
+        auto& successors = sources_[source];
+        successors.total = 0.0;
+        bool found = false;
+        for (auto& [next, count] : successors.next) {
+            count *= DECAY;
+            if (next == package) {
+                count += weight;
+                found = true;
+            }
+            successors.total += count;
+        }
+        if (!found) {
+            if (successors.next.size() >= MAX_SUCCESSORS) {
+                auto weakest = std::min_element(successors.next.begin(), successors.next.end(),
+                    [](const auto& a, const auto& b) { return a.second < b.second; });
+                successors.total -= weakest->second;
+                successors.next.erase(weakest);
+            }
+            successors.next.emplace_back(package, weight);
+            successors.total += weight;
+        }
+        if (sources_.size() > MAX_SOURCES) {
+            auto weakest = sources_.end();
+            for (auto it = sources_.begin(); it != sources_.end(); ++it) {
+                if (it->first != source && (weakest == sources_.end() || it->second.total < weakest->second.total)) {
+                    weakest = it;
+                }
+            }
+            if (weakest != sources_.end()) {
+                sources_.erase(weakest);
+            }
+        }
+    }
+};
+
 struct UserHabits {
     std::map<std::string, AppStats> app_stats;
     int screen_on_duration_avg{ 0 };
@@ -294,15 +1100,22 @@ struct UserHabits {
     std::chrono::system_clock::time_point last_full_save;
     double learning_weight{ 0.7 };
     std::array<TimePattern, 24> daily_patterns;
+    NextAppPredictor next_app; // 前台切换序列模型
+    std::chrono::system_clock::time_point learning_checkpoint{ std::chrono::system_clock::now() }; // 学习时长累计起点
     int learning_hours{ 0 };
     bool learning_complete{ false };
-    std::map<std::string, AppStats> modified_stats; // 用于增量保存的修改记录
     int save_version{ 0 }; // 保存版本号，用于检测文件变化
     bool needs_full_save{ false }; // 标记是否需要完整保存
+    double importance_sum{ 0.0 }; // 重要性>0 的应用权重之和
+    int importance_count{ 0 };    // 重要性>0 的应用数
+    uint32_t last_decay_sweep_hour{ 0 }; // 上次小时计数减半扫描的小时戳
 
     static constexpr int LEARNING_HOURS_TARGET = 72;
     static constexpr int SAVE_INTERVAL_MINUTES = 30; // 每30分钟保存一次
     static constexpr int FULL_SAVE_INTERVAL_HOURS = 12; // 每12小时完整保存一次
+    static constexpr size_t DEFAULT_MAX_APPS = 200; // 默认最多跟踪的应用数
+
+    size_t max_apps{ DEFAULT_MAX_APPS };
 
     void updateTimePattern(int hour, double activity, int freq, const std::vector<std::string>& active_apps) {
         daily_patterns[hour].hour = hour;
@@ -312,10 +1125,11 @@ struct UserHabits {
     void updateLearningProgress() {
         if (learning_complete) return;
         
+        // 只累计整小时，余数留到下次，避免频繁更新时进度被截断为0
         auto now = std::chrono::system_clock::now();
-        auto duration = std::chrono::duration_cast<std::chrono::hours>(now - last_update);
+        auto duration = std::chrono::duration_cast<std::chrono::hours>(now - learning_checkpoint);
         learning_hours += duration.count();
-        last_update = now;
+        learning_checkpoint += duration;
         
         // 随着学习时间增加，学习权重逐渐降低
         learning_weight = std::max(0.0, 0.7 - (static_cast<double>(learning_hours) / LEARNING_HOURS_TARGET * 0.7));
@@ -349,20 +1163,465 @@ struct UserHabits {
         needs_full_save = false;
     }
     
-    void markAppModified(const std::string& package_name) {
-        auto it = app_stats.find(package_name);
-        if (it != app_stats.end()) {
-            modified_stats[package_name] = it->second;
+    // 应用分数变化时增量调整聚合值
+    void updateImportanceAggregate(double previous, double current) {
+        if (previous > 0) {
+            importance_sum -= previous;
+            importance_count--;
+        }
+        if (current > 0) {
+            importance_sum += current;
+            importance_count++;
         }
     }
-    
+
+    void rebuildImportanceAggregate() {
+        importance_sum = 0.0;
+        importance_count = 0;
+        for (const auto& [pkg, stats] : app_stats) {
+            updateImportanceAggregate(0.0, stats.importanceWeight());
+        }
+    }
+
+    // 每小时最多一次：对所有应用补做到期的小时计数减半，未使用的应用同样淡出
+    void decayHourlyUsage(uint32_t now_hour) {
+        if (now_hour == last_decay_sweep_hour) return;
+        last_decay_sweep_hour = now_hour;
+        for (auto& [pkg, stats] : app_stats) {
+            double previous = stats.importanceWeight();
+            if (stats.decayHourlyUsage(now_hour)) {
+                updateImportanceAggregate(previous, stats.importanceWeight());
+            }
+        }
+    }
+
     void clearModifiedApps() {
-        modified_stats.clear();
+        for (auto& [pkg, stats] : app_stats) {
+            stats.dirty = false;
+        }
     }
-};
-class UserHabitManager {
-public:
-    UserHabitManager() { 
+
+    static uint32_t currentHourStamp() {
+        return static_cast<uint32_t>(std::time(nullptr) / 3600);
+    }
+
+    // 超出上限时淘汰价值最低的应用：重要性按闲置天数衰减
+    size_t evictLeastUseful(const std::string& keep = "") {
+        size_t evicted = 0;
+        uint32_t now_hour = currentHourStamp();
+        while (app_stats.size() > max_apps) {
+            auto victim = app_stats.end();
+            double lowest = 0.0;
+            for (auto it = app_stats.begin(); it != app_stats.end(); ++it) {
+                if (it->first == keep) continue;
+                uint32_t idle_hours = now_hour > it->second.last_seen_hour ? now_hour - it->second.last_seen_hour : 0;
+                double usefulness = it->second.importanceWeight() / (1.0 + idle_hours / 24.0);
+                if (victim == app_stats.end() || usefulness < lowest) {
+                    victim = it;
+                    lowest = usefulness;
+                }
+            }
+            if (victim == app_stats.end()) break;
+            updateImportanceAggregate(victim->second.importanceWeight(), 0.0);
+            app_stats.erase(victim);
+            evicted++;
+        }
+        if (evicted > 0) {
+            needs_full_save = true; // 增量保存无法表达删除
+        }
+        return evicted;
+    }
+};
+// 习惯数据快照：控制循环中复制，交给后台写盘线程序列化
+struct HabitSnapshot {
+    bool full{ false };
+    int save_version{ 0 };
+    std::map<std::string, AppStats> apps; // 完整保存为全部应用，增量保存为已修改的应用
+    int screen_on_duration_avg{ 0 };
+    int app_switch_frequency{ 0 };
+    int habit_samples{ 0 };
+    int learning_hours{ 0 };
+    double learning_weight{ 0.0 };
+    bool learning_complete{ false };
+    time_t last_update{ 0 };
+    time_t last_full_save{ 0 };
+    int learning_intensity{ 0 };
+    std::array<TimePattern, 24> daily_patterns; // 仅完整保存
+    nlohmann::json transitions;                 // 仅完整保存
+    std::chrono::steady_clock::time_point created;
+
+    // 合并一个更新的快照（尚未写盘的旧快照被覆盖）
+    void absorb(HabitSnapshot&& newer) {
+        if (newer.full) {
+            *this = std::move(newer);
+            return;
+        }
+        for (auto& [pkg, stats] : newer.apps) {
+            apps.insert_or_assign(pkg, std::move(stats));
+        }
+        save_version = newer.save_version;
+        screen_on_duration_avg = newer.screen_on_duration_avg;
+        app_switch_frequency = newer.app_switch_frequency;
+        habit_samples = newer.habit_samples;
+        learning_hours = newer.learning_hours;
+        learning_weight = newer.learning_weight;
+        learning_complete = newer.learning_complete;
+        last_update = newer.last_update;
+        learning_intensity = newer.learning_intensity;
+    }
+};
+
+// 后台写盘线程：只保留最新的待写快照，连续提交会被合并
+class HabitWriter {
+public:
+    struct Stats {
+        uint64_t saves{ 0 };
+        uint64_t coalesced{ 0 };
+        uint64_t failures{ 0 };
+        double last_ms{ 0.0 };   // 最近一次序列化+写盘+fsync耗时
+        double avg_ms{ 0.0 };
+        double max_ms{ 0.0 };
+        double max_queue_ms{ 0.0 }; // 提交到开始写盘的最长等待
+    };
+
+    explicit HabitWriter(std::string path) : path_(std::move(path)), thread_([this] { run(); }) {}
+
+    ~HabitWriter() { stop(); }
+
+    HabitWriter(const HabitWriter&) = delete;
+    HabitWriter& operator=(const HabitWriter&) = delete;
+
+    void submit(std::shared_ptr<HabitSnapshot> snapshot) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (pending_) {
+                pending_->absorb(std::move(*snapshot));
+                stats_.coalesced++;
+            } else {
+                pending_ = std::move(snapshot);
+            }
+        }
+        cv_.notify_one();
+    }
+
+    // 写完待写快照后退出线程
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stopping_) return;
+            stopping_ = true;
+        }
+        cv_.notify_one();
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+
+    Stats stats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return stats_;
+    }
+
+private:
+    std::string path_;
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::shared_ptr<HabitSnapshot> pending_;
+    bool stopping_{ false };
+    Stats stats_;
+    std::thread thread_; // 最后初始化，确保线程启动时其他成员已就绪
+
+    void run() {
+        while (true) {
+            std::shared_ptr<HabitSnapshot> snapshot;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [this] { return pending_ || stopping_; });
+                if (!pending_) return;
+                snapshot = std::move(pending_);
+            }
+            auto start = std::chrono::steady_clock::now();
+            bool ok = write(*snapshot);
+            auto end = std::chrono::steady_clock::now();
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            double ms = std::chrono::duration<double, std::milli>(end - start).count();
+            double queue_ms = std::chrono::duration<double, std::milli>(start - snapshot->created).count();
+            stats_.saves++;
+            if (!ok) stats_.failures++;
+            stats_.last_ms = ms;
+            stats_.avg_ms += (ms - stats_.avg_ms) / stats_.saves;
+            stats_.max_ms = std::max(stats_.max_ms, ms);
+            stats_.max_queue_ms = std::max(stats_.max_queue_ms, queue_ms);
+        }
+    }
+
+    static nlohmann::json statsToJson(const AppStats& stats) {
+        nlohmann::json stats_json;
+        stats_json["usage_count"] = stats.usage_count;
+        stats_json["total_foreground_time"] = stats.total_foreground_time;
+        stats_json["total_background_time"] = stats.total_background_time;
+        stats_json["switch_count"] = stats.switch_count;
+        stats_json["importance_weight"] = stats.importanceWeight();
+        stats_json["last_usage_hour"] = stats.last_usage_hour;
+        stats_json["usage_pattern_score"] = stats.usagePatternScore();
+        stats_json["last_used_day"] = stats.last_used_day;
+        stats_json["consecutive_days_used"] = stats.consecutive_days_used;
+        stats_json["last_seen_hour"] = stats.last_seen_hour;
+        stats_json["hourly_decay_hour"] = stats.hourly_decay_hour;
+
+        // 小时使用情况与逐日历史，增量记录同样携带，避免重启后丢失两次完整保存之间的变化
+        nlohmann::json hourly_array = nlohmann::json::array();
+        for (uint16_t usage : stats.hourly_usage) {
+            hourly_array.push_back(usage);
+        }
+        stats_json["hourly_usage"] = hourly_array;
+        stats_json["history"] = stats.history.encode();
+        return stats_json;
+    }
+
+    static nlohmann::json serialize(const HabitSnapshot& snapshot) {
+        nlohmann::json j;
+        j["save_version"] = snapshot.save_version;
+
+        if (snapshot.full) {
+            // 完整保存 - 保存所有数据
+            for (const auto& [pkg, stats] : snapshot.apps) {
+                j["app_stats"][pkg] = statsToJson(stats);
+            }
+            
+            j["last_update"] = snapshot.last_update;
+            j["last_full_save"] = snapshot.last_full_save;
+            j["learning_intensity"] = snapshot.learning_intensity;
+
+            // 保存每日模式
+            nlohmann::json patterns_array = nlohmann::json::array();
+            for (const auto& pattern : snapshot.daily_patterns) {
+                nlohmann::json pattern_json;
+                pattern_json["hour"] = pattern.hour;
+                pattern_json["activity_level"] = pattern.activity_level;
+                pattern_json["check_frequency"] = pattern.check_frequency;
+                pattern_json["active_apps"] = pattern.active_apps;
+                patterns_array.push_back(pattern_json);
+            }
+            j["daily_patterns"] = patterns_array;
+            j["transitions"] = snapshot.transitions;
+        } else {
+            // 增量保存 - 只保存修改的数据
+            j["incremental"] = true;
+            j["timestamp"] = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+            for (const auto& [pkg, stats] : snapshot.apps) {
+                j["modified_apps"][pkg] = statsToJson(stats);
+            }
+        }
+
+        j["screen_on_duration_avg"] = snapshot.screen_on_duration_avg;
+        j["app_switch_frequency"] = snapshot.app_switch_frequency;
+        j["habit_samples"] = snapshot.habit_samples;
+        j["learning_weight"] = snapshot.learning_weight;
+        j["learning_hours"] = snapshot.learning_hours;
+        j["learning_complete"] = snapshot.learning_complete;
+        return j;
+    }
+
+    bool write(const HabitSnapshot& snapshot) {
+        std::string json_str;
+        try {
+            json_str = serialize(snapshot).dump(4);
+            json_str += '\n';
+        } catch (const std::exception& e) {
+            Logger::log(Logger::Level::ERROR, std::format("Failed to save user habits: {}", e.what()));
+            return false;
+        }
+
+        // 创建备份文件
+        if (snapshot.full) {
+            std::string backup_path = path_ + ".bak";
+            unlink(backup_path.c_str());
+            rename(path_.c_str(), backup_path.c_str());
+        }
+        
+        int fd = open(path_.c_str(), 
+                     snapshot.full ? (O_WRONLY | O_CREAT | O_TRUNC) : (O_WRONLY | O_CREAT | O_APPEND), 
+                     0644);
+        if (fd == -1) {
+            Logger::log(Logger::Level::ERROR, "Failed to open habits file for writing");
+            return false;
+        }
+        bool ok = ::write(fd, json_str.c_str(), json_str.length()) == static_cast<ssize_t>(json_str.length());
+        fsync(fd);
+        ::close(fd);
+        Logger::log(Logger::Level::INFO, snapshot.full ? 
+            "User habits saved successfully (full save)" : 
+            "User habits updated incrementally");
+        return ok;
+    }
+};
+
+// 电源与温度状态：直接读取 sysfs，替代 dumpsys battery
+struct PowerState {
+    int battery_level{ -1 };        // 百分比，-1 表示未知
+    bool charging{ false };         // 已接外部电源（充电中或已充满）
+    double battery_temp_c{ NAN };
+    double max_thermal_c{ NAN };    // CPU/SoC/机身温区的最高温度
+};
+
+class PowerStateReader {
+public:
+    static PowerState read() {
+        const auto& nodes = discover();
+        PowerState state;
+
+        if (!nodes.battery.empty()) {
+            state.battery_level = readInt(nodes.battery + "/capacity").value_or(-1);
+            std::string status = trim(readProcFile(nodes.battery + "/status"));
+            state.charging = status == "Charging" || status == "Full";
+            if (auto temp = readInt(nodes.battery + "/temp")) {
+                state.battery_temp_c = *temp / 10.0;  // 单位 0.1°C
+            }
+        }
+        for (const auto& online : nodes.chargers) {
+            if (readInt(online).value_or(0) == 1) state.charging = true;
+        }
+        for (const auto& zone : nodes.thermal_zones) {
+            auto temp = readInt(zone);
+            if (!temp) continue;
+            double celsius = *temp / 1000.0;  // 单位 m°C
+            // 未接传感器的温区常报 0 或离谱值
+            if (celsius <= 0.0 || celsius > 150.0) continue;
+            if (std::isnan(state.max_thermal_c) || celsius > state.max_thermal_c) {
+                state.max_thermal_c = celsius;
+            }
+        }
+        return state;
+    }
+
+private:
+    struct Nodes {
+        std::string battery;
+        std::vector<std::string> chargers;       // USB/Mains/Wireless 的 online 节点
+        std::vector<std::string> thermal_zones;  // 相关温区的 temp 节点
+    };
+
+    // 节点在运行期间不会变化，只扫描一次
+    static const Nodes& discover() {
+        static const Nodes nodes = [] {
+            Nodes found;
+            forEachEntry(sysPath("/sys/class/power_supply"), "", [&](const std::string& dir) {
+                std::string type = trim(readProcFile(dir + "/type"));
+                if (type == "Battery" && found.battery.empty()) {
+                    found.battery = dir;
+                } else if ((type == "USB" || type == "Mains" || type == "Wireless" || type.starts_with("USB_")) &&
+                           access((dir + "/online").c_str(), R_OK) == 0) {
+                    found.chargers.push_back(dir + "/online");
+                }
+            });
+            forEachEntry(sysPath("/sys/class/thermal"), "thermal_zone", [&](const std::string& dir) {
+                std::string type = trim(readProcFile(dir + "/type"));
+                std::transform(type.begin(), type.end(), type.begin(), ::tolower);
+                for (const char* keyword : { "cpu", "soc", "skin", "tsens", "battery", "quiet" }) {
+                    if (type.find(keyword) != std::string::npos) {
+                        found.thermal_zones.push_back(dir + "/temp");
+                        break;
+                    }
+                }
+            });
+            Logger::log(Logger::Level::INFO, std::format(
+                "Power state from sysfs: battery {}, {} charger nodes, {} thermal zones",
+                found.battery.empty() ? "not found" : found.battery, found.chargers.size(), found.thermal_zones.size()));
+            return found;
+        }();
+        return nodes;
+    }
+
+    static void forEachEntry(const std::string& root, const char* prefix, const std::function<void(const std::string&)>& visit) {
+        DIR* dir = opendir(root.c_str());
+        if (!dir) return;
+        while (dirent* entry = readdir(dir)) {
+            if (entry->d_name[0] == '.' || strncmp(entry->d_name, prefix, strlen(prefix)) != 0) continue;
+            visit(root + "/" + entry->d_name);
+        }
+        closedir(dir);
+    }
+
+    static std::optional<long> readInt(const std::string& path) {
+        std::string content = readProcFile(path);
+        if (content.empty()) return std::nullopt;
+        char* end = nullptr;
+        long value = strtol(content.c_str(), &end, 10);
+        if (end == content.c_str()) return std::nullopt;
+        return value;
+    }
+
+    static std::string trim(const std::string& value) {
+        size_t end = value.find_last_not_of(" \n\r\t");
+        return end == std::string::npos ? "" : value.substr(0, end + 1);
+    }
+};
+
+// 压制档位：充电时放宽，低电量或过热时收紧
+enum class SuppressionProfile { RELAXED, NORMAL, AGGRESSIVE };
+
+inline const char* profileName(SuppressionProfile profile) {
+    switch (profile) {
+        case SuppressionProfile::RELAXED: return "RELAXED";
+        case SuppressionProfile::AGGRESSIVE: return "AGGRESSIVE";
+        default: return "NORMAL";
+    }
+}
+
+// 各档位对间隔与限制的缩放系数，大于 1 表示更宽松
+struct ProfileScale {
+    double check;     // 检查间隔
+    double kill;      // 后台存活时间（杀死与回收间隔）
+    double throttle;  // CPU预算与 I/O、网络速率上限
+};
+
+// 收紧档只缩短后台存活时间与限制，检查频率不增加，避免低电量或过热时自身唤醒更多
+inline ProfileScale profileScale(SuppressionProfile profile) {
+    switch (profile) {
+        case SuppressionProfile::RELAXED: return { 1.5, 2.0, 1.5 };
+        case SuppressionProfile::AGGRESSIVE: return { 1.0, 0.5, 0.5 };
+        default: return { 1.0, 1.0, 1.0 };
+    }
+}
+
+// 按电源与温度选择档位，阈值带回差以免在边界来回切换
+class ProfileSelector {
+public:
+    SuppressionProfile update(const PowerState& state) {
+        double temp = std::isnan(state.battery_temp_c) ? 0.0 : state.battery_temp_c;
+        double thermal = std::isnan(state.max_thermal_c) ? 0.0 : state.max_thermal_c;
+        hot_ = hot_ ? (temp > BATTERY_HOT_C - HYSTERESIS_C || thermal > THERMAL_HOT_C - HYSTERESIS_C)
+                    : (temp >= BATTERY_HOT_C || thermal >= THERMAL_HOT_C);
+        if (state.battery_level >= 0) {
+            low_battery_ = !state.charging &&
+                (low_battery_ ? state.battery_level < LOW_BATTERY + LOW_BATTERY_HYSTERESIS
+                              : state.battery_level <= LOW_BATTERY);
+        }
+
+        if (hot_ || low_battery_) return SuppressionProfile::AGGRESSIVE;
+        return state.charging ? SuppressionProfile::RELAXED : SuppressionProfile::NORMAL;
+    }
+
+    bool hot() const { return hot_; }
+    bool lowBattery() const { return low_battery_; }
+
+private:
+    static constexpr double BATTERY_HOT_C = 42.0;
+    static constexpr double THERMAL_HOT_C = 75.0;
+    static constexpr double HYSTERESIS_C = 2.0;
+    static constexpr int LOW_BATTERY = 15;
+    static constexpr int LOW_BATTERY_HYSTERESIS = 5;
+
+    bool hot_{ false };
+    bool low_battery_{ false };
+};
+
+class UserHabitManager {
+public:
+    explicit UserHabitManager(const std::string& module_dir = DEFAULT_MODULE_DIR)
+        : habits_path(module_dir + "/" + HABITS_FILE), writer(habits_path) {
         loadHabits(); 
         habits.last_save = std::chrono::system_clock::now();
         habits.last_full_save = habits.last_save;
@@ -374,42 +1633,51 @@ public:
         LOW,     // 低频学习（48-72小时）
         STABLE   // 稳定阶段（72小时后）
     };
-    ~UserHabitManager() { saveHabits(true); }
+    ~UserHabitManager() {
+        saveHabits(true);
+        writer.stop();
+    }
 
     void updateAppStats(const std::string& package_name, bool is_foreground, int duration) {
-        auto& stats = habits.app_stats[package_name];
+        // 先补做到期的减半，再计入本次使用
+        habits.decayHourlyUsage(UserHabits::currentHourStamp());
+        auto [it, inserted] = habits.app_stats.try_emplace(package_name);
+        auto& stats = it->second;
         auto now = std::chrono::system_clock::now();
         auto tt = std::chrono::system_clock::to_time_t(now);
         int hour = localtime(&tt)->tm_hour;
+        // 新应用尚未计入聚合值
+        double previous_importance = inserted ? 0.0 : stats.importanceWeight();
 
+        int today = getCurrentEpochDay();
         if (is_foreground) {
             stats.updateForegroundTime(duration, hour);
+            stats.history.recordOpen(today, hour);
         } else {
             stats.updateBackgroundTime(duration);
+            // 切到后台时 duration 为刚结束的前台时长
+            stats.history.recordForeground(today, duration);
         }
         stats.switch_count++;
-        stats.updateImportanceWeight();
+        stats.last_seen_hour = UserHabits::currentHourStamp();
+        habits.updateImportanceAggregate(previous_importance, stats.importanceWeight());
         habits.app_switch_frequency++;
+        if (inserted && habits.app_stats.size() > habits.max_apps) {
+            size_t evicted = habits.evictLeastUseful(package_name);
+            Logger::log(Logger::Level::INFO, std::format("Evicted {} habit records (cap {})", evicted, habits.max_apps));
+        }
         updateHabits();
         
-        // 标记此应用为已修改
-        habits.markAppModified(package_name);
-        
         // 检查是否应该保存习惯数据
         checkAndSaveHabits();
     }
 
-    void updateScreenStats(bool is_screen_on, int duration) {
+    void updateScreenStats(bool /*is_screen_on*/, int duration) {
         habits.screen_on_duration_avg = static_cast<int>(
             habits.screen_on_duration_avg * (1 - habits.learning_weight) +
             duration * habits.learning_weight
         );
-        if (is_screen_on) {
-            for (auto& [pkg, stats] : habits.app_stats) {
-                stats.updateImportanceWeight();
-                habits.markAppModified(pkg);
-            }
-        }
+        // 重要性与亮屏状态无关，无需逐个应用重算
         updateHabits();
         
         // 检查是否应该保存习惯数据
@@ -428,6 +1696,17 @@ public:
     }
 
     const UserHabits& getHabits() const { return habits; }
+    HabitWriter::Stats writerStats() const { return writer.stats(); }
+
+    static constexpr const char* HABITS_FILE = "module_settings/user_habits.json";  // 相对模块目录
+
+    void setCapacity(size_t max_apps) {
+        habits.max_apps = std::max<size_t>(1, max_apps);
+        size_t evicted = habits.evictLeastUseful();
+        if (evicted > 0) {
+            Logger::log(Logger::Level::INFO, std::format("Evicted {} habit records to fit cap {}", evicted, habits.max_apps));
+        }
+    }
     
     // 学习阶段调整
     void adjustLearningIntensity() {
@@ -458,8 +1737,109 @@ public:
         return learning_intensity;
     }
 
+    // 导入离线工具生成的先验习惯（多设备合并或旧安装导出），按置信度与本地数据混合。
+    // 本地学习越充分，先验权重越低；导入后文件改名为 .imported，避免重复叠加。
+    bool importPriors(const std::string& path) {
+        std::string content = readProcFile(path);
+        if (content.empty()) {
+            return false;
+        }
+
+        try {
+            auto j = nlohmann::json::parse(content);
+            double prior_confidence = std::clamp(j.value("confidence", 0.5), 0.0, 1.0);
+            double local_confidence = std::min(1.0, static_cast<double>(habits.learning_hours) / UserHabits::LEARNING_HOURS_TARGET);
+            double weight = prior_confidence * (1.0 - local_confidence);
+            if (weight <= 0.0) {
+                Logger::log(Logger::Level::INFO, "Habit priors skipped: local data already sufficient");
+                rename(path.c_str(), (path + ".imported").c_str());
+                return false;
+            }
+
+            size_t merged_apps = 0;
+            if (j.contains("app_stats") && j["app_stats"].is_object()) {
+                for (auto& [pkg, stats_json] : j["app_stats"].items()) {
+                    AppStats prior = appStatsFromJson(stats_json);
+                    habits.app_stats[pkg].blend(prior, weight);
+                    merged_apps++;
+                }
+            }
+
+            if (j.contains("daily_patterns") && j["daily_patterns"].is_array()) {
+                auto& patterns_array = j["daily_patterns"];
+                for (size_t i = 0; i < std::min(size_t(24), patterns_array.size()); ++i) {
+                    auto& pattern_json = patterns_array[i];
+                    auto& pattern = habits.daily_patterns[i];
+                    pattern.hour = static_cast<int>(i);
+                    pattern.activity_level = pattern.activity_level * (1.0 - weight) +
+                        pattern_json.value("activity_level", 0.0) * weight;
+                    // 先验应用排在前面，超出10个时优先淘汰，本地活跃应用保留
+                    std::vector<std::string> merged;
+                    if (pattern_json.contains("active_apps") && pattern_json["active_apps"].is_array()) {
+                        for (const auto& app : pattern_json["active_apps"]) {
+                            if (app.is_string() && std::find(pattern.active_apps.begin(), pattern.active_apps.end(),
+                                    app.get<std::string>()) == pattern.active_apps.end()) {
+                                merged.push_back(app);
+                            }
+                        }
+                    }
+                    merged.insert(merged.end(), pattern.active_apps.begin(), pattern.active_apps.end());
+                    if (merged.size() > 10) {
+                        merged.erase(merged.begin(), merged.begin() + (merged.size() - 10));
+                    }
+                    pattern.active_apps = std::move(merged);
+                }
+            }
+
+            if (j.contains("transitions")) {
+                habits.next_app.merge(j["transitions"], weight);
+            }
+
+            // 按权重折算先验覆盖的学习时长
+            int prior_hours = std::min(j.value("learning_hours", 0), UserHabits::LEARNING_HOURS_TARGET);
+            int credited = static_cast<int>(std::lround(prior_hours * prior_confidence));
+            habits.learning_hours = std::min(UserHabits::LEARNING_HOURS_TARGET, habits.learning_hours + credited);
+            habits.updateLearningProgress();
+
+            habits.rebuildImportanceAggregate();
+            habits.evictLeastUseful();
+            habits.needs_full_save = true;
+            init_learning_phase();
+
+            rename(path.c_str(), (path + ".imported").c_str());
+            Logger::log(Logger::Level::INFO, std::format(
+                "Imported habit priors from {}: {} apps, weight {:.2f}, +{}h learning credit",
+                path, merged_apps, weight, credited));
+            return true;
+        } catch (const std::exception& e) {
+            Logger::log(Logger::Level::WARN, std::format("Failed to import habit priors: {}", e.what()));
+            return false;
+        }
+    }
+
+    void observeForeground(const std::set<std::string>& foreground) {
+        habits.next_app.observe(foreground, std::chrono::steady_clock::now());
+    }
+
+    void checkAndSaveHabits() {
+        bool should_save = habits.shouldSaveNow();
+        bool should_full_save = habits.shouldFullSaveNow();
+        
+        if (should_full_save) {
+            saveHabits(true);
+            habits.updateLastFullSaveTime();
+            Logger::log(Logger::Level::INFO, "Performed full save of user habits");
+        } else if (should_save) {
+            saveHabits(false);
+            habits.updateLastSaveTime();
+            Logger::log(Logger::Level::INFO, "Performed incremental save of user habits");
+        }
+    }
+
 private:
     UserHabits habits;
+    std::string habits_path;
+    HabitWriter writer;
     std::chrono::system_clock::time_point learning_start;
     LearningIntensity learning_intensity{LearningIntensity::HIGH};
     LearningIntensity last_learning_intensity{LearningIntensity::HIGH};
@@ -474,12 +1854,17 @@ private:
         double network_rx_rate{0.0};
         int samples{0};
     } system_stats;
+    unsigned long long last_network_rx{0};
+    unsigned long long last_network_tx{0};
+    std::chrono::steady_clock::time_point last_network_sample;
     
     void init_learning_phase() {
-        learning_start = std::chrono::system_clock::now();
-        learning_intensity = LearningIntensity::HIGH;
+        // 由已累计的学习时长回推起点：重启或导入先验后不必从头学习
+        learning_start = std::chrono::system_clock::now() - std::chrono::hours(habits.learning_hours);
+        adjustLearningIntensity();
         last_learning_intensity = learning_intensity;
-        Logger::log(Logger::Level::INFO, "Started learning phase with HIGH intensity");
+        Logger::log(Logger::Level::INFO, std::format("Learning phase at {}h with intensity {}",
+            habits.learning_hours, static_cast<int>(learning_intensity)));
     }
 
     void updateHabits() {
@@ -490,10 +1875,10 @@ private:
         int hour = getCurrentHour();
         double activity = calculateActivityLevel();
         
-        // 收集当前活跃的应用
+        // 收集当前活跃的应用；分数按纪元缓存，未变化的应用不会重算，遍历受应用数上限约束
         std::vector<std::string> active_apps;
         for (const auto& [pkg, stats] : habits.app_stats) {
-            if (stats.importance_weight > 20.0 || stats.last_usage_hour == hour) {
+            if (stats.importanceWeight() > 20.0 || stats.last_usage_hour == hour) {
                 active_apps.push_back(pkg);
             }
         }
@@ -505,38 +1890,48 @@ private:
     }
 
     double calculateActivityLevel() const {
-        if (habits.app_stats.empty()) return 0.0;
+        return habits.importance_count > 0 ? habits.importance_sum / habits.importance_count : 0.0;
+    }
+    
+    static AppStats appStatsFromJson(const nlohmann::json& stats_json) {
+        AppStats stats;
+
+        // 基本统计信息
+        stats.usage_count = stats_json.value("usage_count", 0);
+        stats.total_foreground_time = stats_json.value("total_foreground_time", 0);
+        stats.total_background_time = stats_json.value("total_background_time", 0);
+        stats.switch_count = stats_json.value("switch_count", 0);
+        stats.last_usage_hour = static_cast<int8_t>(stats_json.value("last_usage_hour", -1));
         
-        double total_activity = 0.0;
-        int active_apps = 0;
+        // 新增字段
+        stats.last_used_day = static_cast<int16_t>(stats_json.value("last_used_day", -1));
+        stats.consecutive_days_used = static_cast<uint16_t>(
+            std::clamp(stats_json.value("consecutive_days_used", 0), 0, 0xFFFF));
+        stats.last_seen_hour = stats_json.value("last_seen_hour", UserHabits::currentHourStamp());
+        stats.hourly_decay_hour = stats_json.value("hourly_decay_hour", 0u);
         
-        for (const auto& [pkg, stats] : habits.app_stats) {
-            if (stats.importance_weight > 0) {
-                total_activity += stats.importance_weight;
-                active_apps++;
+        usageFromJson(stats_json, stats);
+        stats.dirty = false;
+        return stats;
+    }
+
+    // 小时使用情况与逐日历史：完整快照与增量记录共用
+    static void usageFromJson(const nlohmann::json& stats_json, AppStats& stats) {
+        if (stats_json.contains("hourly_usage") && stats_json["hourly_usage"].is_array()) {
+            auto& hourly_array = stats_json["hourly_usage"];
+            for (size_t i = 0; i < std::min(size_t(24), hourly_array.size()); ++i) {
+                stats.hourly_usage[i] = static_cast<uint16_t>(
+                    std::clamp(hourly_array[i].get<int>(), 0, static_cast<int>(AppStats::HOURLY_USAGE_MAX)));
             }
         }
-        
-        return active_apps > 0 ? total_activity / active_apps : 0.0;
-    }
-    
-    void checkAndSaveHabits() {
-        bool should_save = habits.shouldSaveNow();
-        bool should_full_save = habits.shouldFullSaveNow();
-        
-        if (should_full_save) {
-            saveHabits(true);
-            habits.updateLastFullSaveTime();
-            Logger::log(Logger::Level::INFO, "Performed full save of user habits");
-        } else if (should_save) {
-            saveHabits(false);
-            habits.updateLastSaveTime();
-            Logger::log(Logger::Level::INFO, "Performed incremental save of user habits");
+        if (stats_json.contains("history") && stats_json["history"].is_array()) {
+            stats.history.decode(stats_json["history"].get<std::vector<uint32_t>>());
         }
+        stats.rebuildHourlyCache();
     }
 
     void loadHabits() {
-        const std::string config_path = "/data/adb/modules/DeepSuppressor/module_settings/user_habits.json";
+        const std::string& config_path = habits_path;
         int fd = open(config_path.c_str(), O_RDONLY);
         if (fd == -1) {
             Logger::log(Logger::Level::INFO, "No existing habits file found, starting fresh");
@@ -552,7 +1947,10 @@ private:
         ::close(fd);
 
         try {
-            auto j = nlohmann::json::parse(content);
+            // 文件开头是完整快照，其后可能追加了若干增量记录
+            std::istringstream stream(content);
+            nlohmann::json j;
+            stream >> j;
             
             // 保存版本号
             habits.save_version = j.value("save_version", 0);
@@ -560,31 +1958,10 @@ private:
             // 加载应用统计信息
             if (j.contains("app_stats") && j["app_stats"].is_object()) {
                 for (auto& [pkg, stats_json] : j["app_stats"].items()) {
-                    AppStats stats;
-                    
-                    // 基本统计信息
-                    stats.usage_count = stats_json.value("usage_count", 0);
-                    stats.total_foreground_time = stats_json.value("total_foreground_time", 0);
-                    stats.total_background_time = stats_json.value("total_background_time", 0);
-                    stats.switch_count = stats_json.value("switch_count", 0);
-                    stats.importance_weight = stats_json.value("importance_weight", 0.0);
-                    stats.last_usage_hour = stats_json.value("last_usage_hour", -1);
-                    stats.usage_pattern_score = stats_json.value("usage_pattern_score", 0.0);
-                    
-                    // 新增字段
-                    stats.last_used_day = stats_json.value("last_used_day", -1);
-                    stats.consecutive_days_used = stats_json.value("consecutive_days_used", 0);
-                    
-                    // 小时使用情况
-                    if (stats_json.contains("hourly_usage") && stats_json["hourly_usage"].is_array()) {
-                        auto& hourly_array = stats_json["hourly_usage"];
-                        for (size_t i = 0; i < std::min(size_t(24), hourly_array.size()); ++i) {
-                            stats.hourly_usage[i] = hourly_array[i];
-                        }
-                    }
-                    
-                    habits.app_stats[pkg] = stats;
+                    habits.app_stats[pkg] = appStatsFromJson(stats_json);
                 }
+                habits.rebuildImportanceAggregate();
+                habits.evictLeastUseful();
             }
             
             // 基本习惯信息
@@ -630,422 +2007,3386 @@ private:
                 }
             }
             
+            if (j.contains("transitions")) {
+                habits.next_app.fromJson(j["transitions"]);
+            }
+
+            int incremental_count = applyIncrementalSaves(stream);
+            if (incremental_count > 0) {
+                habits.rebuildImportanceAggregate();
+                habits.needs_full_save = true; // 合并为单个完整快照
+            }
+            
             // 如果已经是学习完成状态，则跳过高强度学习阶段
             if (habits.learning_complete) {
                 learning_intensity = LearningIntensity::STABLE;
                 last_learning_intensity = learning_intensity;
             }
             
-            Logger::log(Logger::Level::INFO, "User habits loaded successfully");
+            Logger::log(Logger::Level::INFO, std::format("User habits loaded successfully ({} incremental records)",
+                incremental_count));
         } catch (const std::exception& e) {
             Logger::log(Logger::Level::WARN, std::format("Failed to load user habits: {}", e.what()));
         }
     }
 
+    // 依次应用完整快照之后追加的增量记录
+    int applyIncrementalSaves(std::istringstream& stream) {
+        int count = 0;
+        while ((stream >> std::ws) && stream.peek() != EOF) {
+            nlohmann::json j;
+            try {
+                stream >> j;
+            } catch (const std::exception& e) {
+                // 末尾记录可能在写入时被截断
+                Logger::log(Logger::Level::WARN, std::format("Ignoring truncated habit record: {}", e.what()));
+                break;
+            }
+            if (!j.value("incremental", false)) continue;
+            if (j.contains("modified_apps") && j["modified_apps"].is_object()) {
+                for (auto& [pkg, stats_json] : j["modified_apps"].items()) {
+                    auto& stats = habits.app_stats[pkg];
+                    stats.usage_count = stats_json.value("usage_count", stats.usage_count);
+                    stats.total_foreground_time = stats_json.value("total_foreground_time", stats.total_foreground_time);
+                    stats.total_background_time = stats_json.value("total_background_time", stats.total_background_time);
+                    stats.switch_count = stats_json.value("switch_count", stats.switch_count);
+                    stats.last_usage_hour = static_cast<int8_t>(stats_json.value("last_usage_hour", static_cast<int>(stats.last_usage_hour)));
+                    stats.last_used_day = static_cast<int16_t>(stats_json.value("last_used_day", static_cast<int>(stats.last_used_day)));
+                    stats.consecutive_days_used = static_cast<uint16_t>(std::clamp(
+                        stats_json.value("consecutive_days_used", static_cast<int>(stats.consecutive_days_used)), 0, 0xFFFF));
+                    stats.last_seen_hour = stats_json.value("last_seen_hour", stats.last_seen_hour);
+                    stats.hourly_decay_hour = stats_json.value("hourly_decay_hour", stats.hourly_decay_hour);
+                    usageFromJson(stats_json, stats);
+                    stats.dirty = false;
+                }
+            }
+            habits.screen_on_duration_avg = j.value("screen_on_duration_avg", habits.screen_on_duration_avg);
+            habits.app_switch_frequency = j.value("app_switch_frequency", habits.app_switch_frequency);
+            habits.habit_samples = j.value("habit_samples", habits.habit_samples);
+            habits.learning_hours = j.value("learning_hours", habits.learning_hours);
+            habits.learning_weight = j.value("learning_weight", habits.learning_weight);
+            habits.learning_complete = j.value("learning_complete", habits.learning_complete);
+            count++;
+        }
+        return count;
+    }
+
+    // 在控制循环中只复制需要保存的记录，序列化与写盘交给后台线程
     void saveHabits(bool full_save = false) {
-        const std::string config_path = "/data/adb/modules/DeepSuppressor/module_settings/user_habits.json";
-        // 创建备份文件
+        auto snapshot = std::make_shared<HabitSnapshot>();
+        snapshot->full = full_save;
+        snapshot->created = std::chrono::steady_clock::now();
         if (full_save) {
-            std::string backup_path = config_path + ".bak";
-            unlink(backup_path.c_str());
-            rename(config_path.c_str(), backup_path.c_str());
+            habits.save_version++;
         }
-        
-        int fd = open(config_path.c_str(), 
-                     full_save ? (O_WRONLY | O_CREAT | O_TRUNC) : (O_WRONLY | O_CREAT | O_APPEND), 
-                     0644);
-        if (fd == -1) {
-            Logger::log(Logger::Level::ERROR, "Failed to open habits file for writing");
-            return;
+        snapshot->save_version = habits.save_version;
+        for (const auto& [pkg, stats] : habits.app_stats) {
+            if (full_save || stats.dirty) {
+                snapshot->apps.emplace(pkg, stats);
+            }
         }
-
+        snapshot->screen_on_duration_avg = habits.screen_on_duration_avg;
+        snapshot->app_switch_frequency = habits.app_switch_frequency;
+        snapshot->habit_samples = habits.habit_samples;
+        snapshot->learning_hours = habits.learning_hours;
+        snapshot->learning_weight = habits.learning_weight;
+        snapshot->learning_complete = habits.learning_complete;
+        snapshot->last_update = std::chrono::system_clock::to_time_t(habits.last_update);
+        snapshot->last_full_save = std::chrono::system_clock::to_time_t(habits.last_full_save);
+        snapshot->learning_intensity = static_cast<int>(learning_intensity);
+        if (full_save) {
+            snapshot->daily_patterns = habits.daily_patterns;
+            snapshot->transitions = habits.next_app.toJson();
+        }
+        habits.clearModifiedApps();
+        writer.submit(std::move(snapshot));
+    }
+    
+    // 采集电池状态信息
+    void captureBatteryStats() {
+        auto state = PowerStateReader::read();
+        system_stats.battery_level = state.battery_level;
+    }
+    
+    // 采集内存使用状况
+    void captureMemoryStats() {
+        // "Free RAM" 行位于 "Total RAM" 之后，读到即可停止
+        std::string output = SystemProbe::current().run({ "dumpsys", "meminfo" }, CommandRunner::stopAfter("Free RAM:"));
         try {
-            nlohmann::json j;
+            // 解析总内存和可用内存
+            size_t total_pos = output.find("Total RAM:");
+            size_t free_pos = output.find("Free RAM:");
             
-            if (full_save) {
-                // 完整保存 - 保存所有数据
-                habits.save_version++;
-                j["save_version"] = habits.save_version;
-                
-                // 保存应用统计信息
-                for (const auto& [pkg, stats] : habits.app_stats) {
-                    nlohmann::json stats_json;
-                    
-                    // 基本统计信息
-                    stats_json["usage_count"] = stats.usage_count;
-                    stats_json["total_foreground_time"] = stats.total_foreground_time;
-                    stats_json["total_background_time"] = stats.total_background_time;
-                    stats_json["switch_count"] = stats.switch_count;
-                    stats_json["importance_weight"] = stats.importance_weight;
-                    stats_json["last_usage_hour"] = stats.last_usage_hour;
-                    stats_json["usage_pattern_score"] = stats.usage_pattern_score;
-                    
-                    // 新增字段
-                    stats_json["last_used_day"] = stats.last_used_day;
-                    stats_json["consecutive_days_used"] = stats.consecutive_days_used;
-                    
-                    // 小时使用情况
-                    nlohmann::json hourly_array = nlohmann::json::array();
-                    for (int usage : stats.hourly_usage) {
-                        hourly_array.push_back(usage);
+            if (total_pos != std::string::npos && free_pos != std::string::npos) {
+                std::string total_str = output.substr(total_pos + 10, output.find("K", total_pos) - total_pos - 10);
+                std::string free_str = output.substr(free_pos + 9, output.find("K", free_pos) - free_pos - 9);
+                
+                long total_ram = std::stol(total_str);
+                long free_ram = std::stol(free_str);
+                
+                // 更新系统统计
+                if (system_stats.samples == 0) {
+                    system_stats.total_memory = total_ram;
+                    system_stats.avg_free_memory = free_ram;
+                } else {
+                    // 使用指数移动平均
+                    system_stats.avg_free_memory = static_cast<long>(
+                        system_stats.avg_free_memory * 0.8 + free_ram * 0.2);
+                }
+            }
+        } catch (const std::exception& e) {
+            Logger::log(Logger::Level::WARN, "Failed to parse memory stats");
+        }
+    }
+    
+    // 采集网络活动信息
+    void captureNetworkActivity() {
+        unsigned long long rx_bytes, tx_bytes;
+        if (!readNetDevTotals(sysPath("/proc/net/dev"), rx_bytes, tx_bytes)) {
+            Logger::log(Logger::Level::WARN, "Failed to read network stats");
+            return;
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (last_network_sample.time_since_epoch().count() != 0 &&
+            rx_bytes >= last_network_rx && tx_bytes >= last_network_tx) {
+            double elapsed = std::chrono::duration<double>(now - last_network_sample).count();
+            if (elapsed > 0) {
+                double rx_rate = (rx_bytes - last_network_rx) / elapsed;
+                double tx_rate = (tx_bytes - last_network_tx) / elapsed;
+                // 使用指数移动平均
+                system_stats.network_rx_rate = system_stats.network_rx_rate * 0.8 + rx_rate * 0.2;
+                system_stats.network_tx_rate = system_stats.network_tx_rate * 0.8 + tx_rate * 0.2;
+            }
+        }
+        last_network_rx = rx_bytes;
+        last_network_tx = tx_bytes;
+        last_network_sample = now;
+        system_stats.samples++;
+    }
+};
+
+// 压制策略参数表：间隔、资源阈值与优先级范围集中在此，由策略对象提供
+struct PolicyTable {
+    // 一类间隔：稳定阶段的范围与默认值，学习阶段按 HIGH/MEDIUM/LOW 取固定值
+    struct Intervals {
+        std::chrono::seconds min;
+        std::chrono::seconds max;
+        std::chrono::seconds fallback;
+        std::array<std::chrono::seconds, 3> learning;
+    };
+
+    Intervals screen_check;
+    Intervals process_check;
+    Intervals kill;
+    Intervals screen_off_sleep;
+    std::chrono::seconds kill_important_app;   // 学习阶段重要应用的后台存活时间
+    std::chrono::seconds reclaim_min;
+    double important_app_weight;               // 学习阶段视为重要应用的重要性
+    double active_probability;                 // 使用概率达到该值即视为完全活跃
+    double active_time_factor;                 // 活跃时段对检查/杀死间隔的最大调整幅度
+    double likely_next_probability;            // 视为即将打开的概率
+    int heavy_memory_kb;                       // 资源占用高的判定
+    int heavy_cpu_percent;
+    double heavy_kill_factor;                  // 资源占用高时杀死间隔的系数
+    double leak_kill_factor;                   // 疑似内存泄漏时杀死间隔的系数
+    double screen_off_keep_importance;         // 息屏清理时保留的最低重要性
+    int oom_adj_min;                           // 后台进程 OOM 分数范围，重要应用取低值
+    int oom_adj_max;
+    int nice_min;                              // 后台进程 nice 范围
+    int nice_max;
+};
+
+enum class PolicyKind : uint8_t { BALANCED, AGGRESSIVE, CONSERVATIVE, TABLE };
+
+inline const char* policyName(PolicyKind kind) {
+    switch (kind) {
+        case PolicyKind::AGGRESSIVE: return "aggressive";
+        case PolicyKind::CONSERVATIVE: return "conservative";
+        case PolicyKind::TABLE: return "table";
+        default: return "balanced";
+    }
+}
+
+// 内置策略：参数表为编译期常量，热路径上的阈值可直接内联
+template <PolicyKind Kind>
+struct BuiltinPolicy;
+
+template <>
+struct BuiltinPolicy<PolicyKind::BALANCED> {
+    static constexpr PolicyKind KIND = PolicyKind::BALANCED;
+    static constexpr PolicyTable TABLE = {
+        .screen_check = { std::chrono::seconds(30), std::chrono::minutes(5), std::chrono::minutes(5),
+                          { std::chrono::seconds(15), std::chrono::seconds(30), std::chrono::seconds(45) } },
+        .process_check = { std::chrono::seconds(45), std::chrono::minutes(3), std::chrono::minutes(1),
+                           { std::chrono::seconds(20), std::chrono::seconds(30), std::chrono::seconds(40) } },
+        .kill = { std::chrono::minutes(5), std::chrono::minutes(30), std::chrono::minutes(10),
+                  { std::chrono::minutes(3), std::chrono::minutes(5), std::chrono::minutes(7) } },
+        .screen_off_sleep = { std::chrono::minutes(1), std::chrono::minutes(1), std::chrono::minutes(1),
+                              { std::chrono::seconds(30), std::chrono::seconds(40), std::chrono::seconds(50) } },
+        .kill_important_app = std::chrono::minutes(15),
+        .reclaim_min = std::chrono::minutes(1),
+        .important_app_weight = 50.0,
+        .active_probability = 0.5,
+        .active_time_factor = 0.3,
+        .likely_next_probability = 0.25,
+        .heavy_memory_kb = 150000,
+        .heavy_cpu_percent = 5,
+        .heavy_kill_factor = 0.7,
+        .leak_kill_factor = 0.5,
+        .screen_off_keep_importance = 30.0,
+        .oom_adj_min = 100,
+        .oom_adj_max = 900,
+        .nice_min = 10,
+        .nice_max = 19,
+    };
+    const PolicyTable& table() const { return TABLE; }
+};
+
+template <>
+struct BuiltinPolicy<PolicyKind::AGGRESSIVE> {
+    static constexpr PolicyKind KIND = PolicyKind::AGGRESSIVE;
+    static constexpr PolicyTable TABLE = {
+        .screen_check = { std::chrono::seconds(30), std::chrono::minutes(5), std::chrono::minutes(5),
+                          { std::chrono::seconds(15), std::chrono::seconds(30), std::chrono::seconds(45) } },
+        .process_check = { std::chrono::seconds(30), std::chrono::minutes(2), std::chrono::seconds(45),
+                           { std::chrono::seconds(20), std::chrono::seconds(25), std::chrono::seconds(30) } },
+        .kill = { std::chrono::minutes(2), std::chrono::minutes(15), std::chrono::minutes(5),
+                  { std::chrono::minutes(2), std::chrono::minutes(3), std::chrono::minutes(4) } },
+        .screen_off_sleep = { std::chrono::minutes(1), std::chrono::minutes(1), std::chrono::minutes(1),
+                              { std::chrono::seconds(30), std::chrono::seconds(40), std::chrono::seconds(50) } },
+        .kill_important_app = std::chrono::minutes(10),
+        .reclaim_min = std::chrono::seconds(30),
+        .important_app_weight = 60.0,
+        .active_probability = 0.6,
+        .active_time_factor = 0.2,
+        .likely_next_probability = 0.35,
+        .heavy_memory_kb = 100000,
+        .heavy_cpu_percent = 3,
+        .heavy_kill_factor = 0.5,
+        .leak_kill_factor = 0.3,
+        .screen_off_keep_importance = 50.0,
+        .oom_adj_min = 200,
+        .oom_adj_max = 950,
+        .nice_min = 12,
+        .nice_max = 19,
+    };
+    const PolicyTable& table() const { return TABLE; }
+};
+
+template <>
+struct BuiltinPolicy<PolicyKind::CONSERVATIVE> {
+    static constexpr PolicyKind KIND = PolicyKind::CONSERVATIVE;
+    static constexpr PolicyTable TABLE = {
+        .screen_check = { std::chrono::seconds(45), std::chrono::minutes(5), std::chrono::minutes(5),
+                          { std::chrono::seconds(20), std::chrono::seconds(40), std::chrono::minutes(1) } },
+        .process_check = { std::chrono::minutes(1), std::chrono::minutes(5), std::chrono::minutes(2),
+                           { std::chrono::seconds(30), std::chrono::seconds(45), std::chrono::minutes(1) } },
+        .kill = { std::chrono::minutes(10), std::chrono::minutes(60), std::chrono::minutes(20),
+                  { std::chrono::minutes(5), std::chrono::minutes(8), std::chrono::minutes(10) } },
+        .screen_off_sleep = { std::chrono::minutes(2), std::chrono::minutes(2), std::chrono::minutes(2),
+                              { std::chrono::seconds(45), std::chrono::minutes(1), std::chrono::seconds(90) } },
+        .kill_important_app = std::chrono::minutes(30),
+        .reclaim_min = std::chrono::minutes(3),
+        .important_app_weight = 40.0,
+        .active_probability = 0.4,
+        .active_time_factor = 0.4,
+        .likely_next_probability = 0.2,
+        .heavy_memory_kb = 250000,
+        .heavy_cpu_percent = 10,
+        .heavy_kill_factor = 0.85,
+        .leak_kill_factor = 0.7,
+        .screen_off_keep_importance = 15.0,
+        .oom_adj_min = 100,
+        .oom_adj_max = 800,
+        .nice_min = 5,
+        .nice_max = 15,
+    };
+    const PolicyTable& table() const { return TABLE; }
+};
+
+// 数据驱动策略：以内置策略为基础，用配置文件中的字段覆盖
+class TablePolicy {
+public:
+    static constexpr PolicyKind KIND = PolicyKind::TABLE;
+
+    explicit TablePolicy(const PolicyTable& table) : table_(table) {}
+
+    const PolicyTable& table() const { return table_; }
+
+    // 格式：{ "base": "balanced", "kill_interval": { "min": 300, "learning": [180, 300, 420] }, "heavy_memory_kb": 120000, ... }
+    // 间隔单位为秒；未给出的字段沿用 base 策略
+    static std::optional<TablePolicy> load(const std::string& path) {
+        std::string content = readProcFile(path);
+        if (content.empty()) {
+            Logger::log(Logger::Level::WARN, std::format("Policy file not readable: {}", path));
+            return std::nullopt;
+        }
+        try {
+            auto j = nlohmann::json::parse(content);
+            std::string base = j.value("base", "balanced");
+            PolicyTable table = base == "aggressive" ? BuiltinPolicy<PolicyKind::AGGRESSIVE>::TABLE :
+                                base == "conservative" ? BuiltinPolicy<PolicyKind::CONSERVATIVE>::TABLE :
+                                BuiltinPolicy<PolicyKind::BALANCED>::TABLE;
+
+            readIntervals(j, "screen_check_interval", table.screen_check);
+            readIntervals(j, "process_check_interval", table.process_check);
+            readIntervals(j, "kill_interval", table.kill);
+            readIntervals(j, "screen_off_sleep_interval", table.screen_off_sleep);
+            table.kill_important_app = std::chrono::seconds(j.value("kill_important_app", table.kill_important_app.count()));
+            table.reclaim_min = std::chrono::seconds(j.value("reclaim_min", table.reclaim_min.count()));
+            table.important_app_weight = j.value("important_app_weight", table.important_app_weight);
+            table.active_probability = j.value("active_probability", table.active_probability);
+            table.active_time_factor = j.value("active_time_factor", table.active_time_factor);
+            table.likely_next_probability = j.value("likely_next_probability", table.likely_next_probability);
+            table.heavy_memory_kb = j.value("heavy_memory_kb", table.heavy_memory_kb);
+            table.heavy_cpu_percent = j.value("heavy_cpu_percent", table.heavy_cpu_percent);
+            table.heavy_kill_factor = j.value("heavy_kill_factor", table.heavy_kill_factor);
+            table.leak_kill_factor = j.value("leak_kill_factor", table.leak_kill_factor);
+            table.screen_off_keep_importance = j.value("screen_off_keep_importance", table.screen_off_keep_importance);
+            table.oom_adj_min = j.value("oom_adj_min", table.oom_adj_min);
+            table.oom_adj_max = j.value("oom_adj_max", table.oom_adj_max);
+            table.nice_min = j.value("nice_min", table.nice_min);
+            table.nice_max = j.value("nice_max", table.nice_max);
+
+            if (auto error = validate(table)) {
+                Logger::log(Logger::Level::WARN, std::format("Invalid policy file {}: {}", path, *error));
+                return std::nullopt;
+            }
+            Logger::log(Logger::Level::INFO, std::format("Loaded policy table from {} (base: {})", path, base));
+            return TablePolicy(table);
+        } catch (const std::exception& e) {
+            Logger::log(Logger::Level::WARN, std::format("Failed to parse policy file {}: {}", path, e.what()));
+            return std::nullopt;
+        }
+    }
+
+private:
+    PolicyTable table_;
+
+    static void readIntervals(const nlohmann::json& j, const char* key, PolicyTable::Intervals& intervals) {
+        if (!j.contains(key)) return;
+        const auto& entry = j[key];
+        intervals.min = std::chrono::seconds(entry.value("min", intervals.min.count()));
+        intervals.max = std::chrono::seconds(entry.value("max", intervals.max.count()));
+        intervals.fallback = std::chrono::seconds(entry.value("default", intervals.fallback.count()));
+        if (entry.contains("learning")) {
+            for (size_t i = 0; i < intervals.learning.size() && i < entry["learning"].size(); ++i) {
+                intervals.learning[i] = std::chrono::seconds(entry["learning"][i].get<long long>());
+            }
+        }
+    }
+
+    static std::optional<std::string> validate(const PolicyTable& table) {
+        for (const auto* intervals : { &table.screen_check, &table.process_check, &table.kill, &table.screen_off_sleep }) {
+            if (intervals->min.count() <= 0 || intervals->min > intervals->max) return "interval min must be in (0, max]";
+            // 间隔为 0 会让调度器在每次唤醒时重复触发
+            if (intervals->fallback.count() <= 0) return "interval default must be positive";
+            for (auto learning : intervals->learning) {
+                if (learning.count() <= 0) return "learning intervals must be positive";
+            }
+        }
+        if (table.oom_adj_min < 0 || table.oom_adj_min > table.oom_adj_max || table.oom_adj_max > 1000) {
+            return "oom_adj range must be within [0, 1000]";
+        }
+        if (table.nice_min < -20 || table.nice_min > table.nice_max || table.nice_max > 19) {
+            return "nice range must be within [-20, 19]";
+        }
+        if (table.kill_important_app.count() <= 0) return "kill_important_app must be positive";
+        if (table.reclaim_min.count() <= 0) return "reclaim_min must be positive";
+        if (table.active_probability <= 0.0) return "active_probability must be positive";
+        auto unit = [](double value) { return value > 0.0 && value <= 1.0; };
+        if (!unit(table.likely_next_probability)) return "likely_next_probability must be in (0, 1]";
+        if (!unit(table.heavy_kill_factor)) return "heavy_kill_factor must be in (0, 1]";
+        if (!unit(table.leak_kill_factor)) return "leak_kill_factor must be in (0, 1]";
+        return std::nullopt;
+    }
+};
+
+// 间隔计算：参数来自策略对象，内置策略在编译期特化
+template <typename Policy>
+class IntervalManager {
+public:
+    IntervalManager(const UserHabits& habits, const UserHabitManager& habit_manager, Policy policy = {})
+        : habits_(habits), habit_manager_(habit_manager), policy_(std::move(policy)) {}
+
+    const PolicyTable& table() const { return policy_.table(); }
+
+    // 电源/温度档位对所有间隔的统一缩放
+    void setProfile(SuppressionProfile profile) {
+        profile_ = profile;
+        scale_ = profileScale(profile);
+    }
+
+    SuppressionProfile profile() const { return profile_; }
+    double throttleScale() const { return scale_.throttle; }
+
+    std::chrono::seconds getScreenCheckInterval() const {
+        return scaled(baseScreenCheckInterval(), scale_.check);
+    }
+
+    std::chrono::seconds getProcessCheckInterval(const std::string& package_name) const {
+        return scaled(baseProcessCheckInterval(package_name), scale_.check);
+    }
+
+    std::chrono::seconds getKillInterval(const std::string& package_name) const {
+        return scaled(baseKillInterval(package_name), scale_.kill);
+    }
+
+    std::chrono::seconds getScreenOffSleepInterval() const {
+        return scaled(baseScreenOffSleepInterval(), scale_.check);
+    }
+
+    // 后台多久后回收内存：取杀死间隔的三分之一，重要应用相应推迟
+    std::chrono::seconds getReclaimInterval(const std::string& package_name) const {
+        auto interval = getKillInterval(package_name) / 3;
+        return std::max(table().reclaim_min, interval);
+    }
+
+    // 当前星期与小时的使用概率；无逐日历史时回退到时段活跃列表（0或1）
+    double usageProbability(const std::string& package_name, const AppStats& stats) const {
+        int today = getCurrentEpochDay();
+        int current_hour = getCurrentHour();
+        double probability = stats.history.probability(today, weekdayOfEpochDay(today), current_hour);
+        if (probability >= 0.0) {
+            return probability;
+        }
+        const auto& pattern = habits_.daily_patterns[current_hour];
+        return std::find(pattern.active_apps.begin(), pattern.active_apps.end(),
+                         package_name) != pattern.active_apps.end() ? 1.0 : 0.0;
+    }
+
+    // 预测窗口内被打开的概率：切换模型按置信度与星期×小时先验混合
+    double nextUsageProbability(const std::string& package_name) const {
+        auto prediction = habits_.next_app.predict(package_name, std::chrono::steady_clock::now());
+        double prior = 0.0;
+        auto it = habits_.app_stats.find(package_name);
+        if (it != habits_.app_stats.end()) {
+            // 小时内至少打开一次的概率折算到预测窗口：假定打开在小时内均匀分布
+            int today = getCurrentEpochDay();
+            double hourly = std::clamp(
+                it->second.history.probability(today, weekdayOfEpochDay(today), getCurrentHour()), 0.0, 1.0);
+            prior = 1.0 - std::pow(1.0 - hourly,
+                std::chrono::duration<double>(NextAppPredictor::WINDOW) / std::chrono::hours(1));
+        }
+        return prediction.confidence * prediction.probability + (1.0 - prediction.confidence) * prior;
+    }
+
+    bool isLikelyNext(const std::string& package_name) const {
+        return nextUsageProbability(package_name) >= table().likely_next_probability;
+    }
+
+private:
+    const UserHabits& habits_;
+    const UserHabitManager& habit_manager_;
+    Policy policy_;
+    SuppressionProfile profile_{ SuppressionProfile::NORMAL };
+    ProfileScale scale_{ profileScale(SuppressionProfile::NORMAL) };
+
+    static std::chrono::seconds scaled(std::chrono::seconds interval, double factor) {
+        return std::chrono::seconds(static_cast<long long>(interval.count() * factor));
+    }
+
+    // 学习阶段的固定间隔，按 HIGH/MEDIUM/LOW 取表中的值
+    static std::chrono::seconds learningInterval(const PolicyTable::Intervals& intervals,
+                                                 UserHabitManager::LearningIntensity intensity) {
+        size_t index = static_cast<size_t>(intensity);
+        return index < intervals.learning.size() ? intervals.learning[index] : intervals.fallback;
+    }
+
+    std::chrono::seconds baseScreenCheckInterval() const {
+        const auto& intervals = table().screen_check;
+        // 根据学习阶段调整检查间隔
+        auto intensity = habit_manager_.getLearningIntensity();
+        
+        // 根据当前时间段的活动水平调整屏幕检查间隔
+        int current_hour = getCurrentHour();
+        const auto& pattern = habits_.daily_patterns[current_hour];
+        
+        if (intensity == UserHabitManager::LearningIntensity::STABLE) {
+            // 学习完成后，根据当前时段活动水平动态调整
+            double activity_factor = std::min(1.0, pattern.activity_level);
+            auto dynamic_interval = static_cast<long long>(
+                intervals.max.count() - (intervals.max - intervals.min).count() * activity_factor
+            );
+            return std::chrono::seconds(dynamic_interval);
+        }
+        
+        // 在学习阶段，适当考虑时间模式，但以学习强度为主
+        double activity_factor = std::min(0.5, pattern.activity_level / 2);
+        auto adjusted_interval = static_cast<long long>(
+            learningInterval(intervals, intensity).count() * (1.0 - activity_factor)
+        );
+        
+        return std::chrono::seconds(adjusted_interval);
+    }
+
+    std::chrono::seconds baseProcessCheckInterval(const std::string& package_name) const {
+        const auto& intervals = table().process_check;
+        auto intensity = habit_manager_.getLearningIntensity();
+        
+        // 学习阶段使用更短的固定间隔
+        if (intensity != UserHabitManager::LearningIntensity::STABLE) {
+            return learningInterval(intervals, intensity);
+        }
+        
+        // 稳定阶段，基于学习到的用户习惯调整
+        auto it = habits_.app_stats.find(package_name);
+        if (it == habits_.app_stats.end()) {
+            return intervals.fallback;
+        }
+        
+        // 考虑应用重要性和当前时段
+        double importance = it->second.importanceWeight();
+        
+        // 活跃应用在其活跃时段检查更频繁
+        double time_factor = 1.0 - table().active_time_factor * activeness(package_name, it->second);
+        
+        auto interval = static_cast<long long>(
+            intervals.max.count() -
+            (intervals.max - intervals.min).count() * 
+            (importance / 100.0) * time_factor
+        );
+        
+        interval = std::max(interval, static_cast<long long>(intervals.min.count()));
+        return std::chrono::seconds(interval);
+    }
+
+    std::chrono::seconds baseKillInterval(const std::string& package_name) const {
+        const auto& intervals = table().kill;
+        // 即将被打开的应用不杀，避免刚杀就冷启动
+        if (isLikelyNext(package_name)) {
+            return intervals.max;
+        }
+
+        auto intensity = habit_manager_.getLearningIntensity();
+        
+        // 学习阶段使用更短的固定间隔，但不会太短以避免误杀常用应用
+        if (intensity != UserHabitManager::LearningIntensity::STABLE) {
+            // 即使在学习阶段，也要考虑应用重要性
+            auto it = habits_.app_stats.find(package_name);
+            if (it != habits_.app_stats.end() && it->second.importanceWeight() > table().important_app_weight) {
+                // 重要应用即使在学习阶段也应该有更长的存活时间
+                return table().kill_important_app;
+            }
+            return learningInterval(intervals, intensity);
+        }
+        
+        // 稳定阶段，基于学习到的用户习惯调整
+        auto it = habits_.app_stats.find(package_name);
+        if (it == habits_.app_stats.end()) {
+            return intervals.fallback;
+        }
+        
+        // 重要应用有更长的后台存活时间
+        double importance = it->second.importanceWeight();
+        
+        // 在活跃时段，即使在后台也给予更长的存活时间
+        double time_factor = 1.0 + table().active_time_factor * activeness(package_name, it->second);
+        
+        auto interval = static_cast<long long>(
+            intervals.min.count() +
+            (intervals.max - intervals.min).count() * 
+            (importance / 100.0) * time_factor
+        );
+        
+        interval = std::min(interval, static_cast<long long>(intervals.max.count()));
+        return std::chrono::seconds(interval);
+    }
+
+    std::chrono::seconds baseScreenOffSleepInterval() const {
+        auto intensity = habit_manager_.getLearningIntensity();
+        
+        // 学习阶段使用更短的休眠间隔
+        if (intensity != UserHabitManager::LearningIntensity::STABLE) {
+            return learningInterval(table().screen_off_sleep, intensity);
+        }
+        return table().screen_off_sleep.fallback;
+    }
+
+    double activeness(const std::string& package_name, const AppStats& stats) const {
+        return std::min(1.0, usageProbability(package_name, stats) / table().active_probability);
+    }
+};
+
+// 后台进程内存回收：在不杀死进程的前提下换出其匿名页和文件页
+class MemoryReclaimer {
+public:
+    // 回收指定进程的内存，返回实际回收的字节数（RSS 差值），失败返回 -1
+    static long long reclaim(pid_t pid) {
+        long long rss_before = readRssBytes(pid);
+        if (rss_before <= 0) return -1;
+
+        // 夹具中的 pid 不对应本机进程，不能用 pidfd 直接操作
+        bool reclaimed = SystemProbe::current().hostPids() && pageoutWithProcessMadvise(pid);
+        if (!reclaimed) {
+            reclaimed = reclaimWithCgroup(pid, rss_before);
+        }
+        if (!reclaimed) return -1;
+
+        long long rss_after = readRssBytes(pid);
+        if (rss_after < 0) return -1;
+        return std::max(0LL, rss_before - rss_after);
+    }
+
+    static long long readRssBytes(pid_t pid) {
+        // statm 第二个字段为常驻页数
+        std::string statm = readProcFile(sysPath("/proc/" + std::to_string(pid) + "/statm"));
+        if (statm.empty()) return -1;
+
+        size_t space = statm.find(' ');
+        if (space == std::string::npos) return -1;
+        try {
+            long long resident_pages = std::stoll(statm.substr(space + 1));
+            return resident_pages * sysconf(_SC_PAGESIZE);
+        } catch (const std::exception&) {
+            return -1;
+        }
+    }
+
+    // 比例集大小（PSS），共享页按比例分摊，用于估算杀死进程可释放的内存
+    static long long readPssBytes(pid_t pid) {
+        std::string rollup = readProcFile(sysPath("/proc/" + std::to_string(pid) + "/smaps_rollup"));
+        size_t pos = rollup.find("\nPss:");
+        if (pos == std::string::npos) return readRssBytes(pid);
+        return strtoll(rollup.c_str() + pos + 5, nullptr, 10) * 1024;
+    }
+
+private:
+    static constexpr size_t MAX_IOVECS_PER_CALL = 512;
+
+    // 通过 pidfd + process_madvise(MADV_PAGEOUT) 换出进程的全部可回收映射
+    static bool pageoutWithProcessMadvise(pid_t pid) {
+        std::string maps = readProcFile(sysPath("/proc/" + std::to_string(pid) + "/maps"));
+        if (maps.empty()) return false;
+
+        std::vector<iovec> ranges;
+        size_t line_start = 0;
+        while (line_start < maps.size()) {
+            size_t line_end = maps.find('\n', line_start);
+            if (line_end == std::string::npos) line_end = maps.size();
+            std::string_view line(maps.data() + line_start, line_end - line_start);
+            line_start = line_end + 1;
+
+            // 跳过内核提供的特殊映射
+            if (line.find("[vdso]") != std::string_view::npos ||
+                line.find("[vvar]") != std::string_view::npos ||
+                line.find("[vsyscall]") != std::string_view::npos) {
+                continue;
+            }
+
+            unsigned long start = 0, end = 0;
+            if (sscanf(std::string(line.substr(0, line.find(' '))).c_str(), "%lx-%lx", &start, &end) != 2 ||
+                end <= start) {
+                continue;
+            }
+            ranges.push_back({ reinterpret_cast<void*>(start), end - start });
+        }
+        if (ranges.empty()) return false;
+
+        int pidfd = static_cast<int>(syscall(SYS_pidfd_open, pid, 0));
+        if (pidfd == -1) return false;
+
+        bool any_success = false;
+        for (size_t i = 0; i < ranges.size(); i += MAX_IOVECS_PER_CALL) {
+            size_t count = std::min(MAX_IOVECS_PER_CALL, ranges.size() - i);
+            long ret = syscall(SYS_process_madvise, pidfd, &ranges[i], count, MADV_PAGEOUT, 0);
+            if (ret >= 0) {
+                any_success = true;
+            } else if (errno == ENOSYS || errno == EPERM || errno == ESRCH) {
+                break; // 内核不支持或进程已退出，无需继续
+            }
+        }
+        ::close(pidfd);
+        return any_success;
+    }
+
+    // 回退方案：写入进程所属 cgroup v2 的 memory.reclaim
+    static bool reclaimWithCgroup(pid_t pid, long long bytes) {
+        std::string cgroup_path = getCgroupV2Path(pid);
+        if (cgroup_path.empty()) return false;
+        std::string reclaim_path = sysPath("/sys/fs/cgroup" + cgroup_path + "/memory.reclaim");
+
+        int fd = open(reclaim_path.c_str(), O_WRONLY | O_CLOEXEC);
+        if (fd == -1) return false;
+        std::string amount = std::to_string(bytes);
+        // 内核在无法回收全部请求量时返回 EAGAIN，但已回收的部分仍然有效
+        bool ok = write(fd, amount.data(), amount.size()) > 0 || errno == EAGAIN;
+        ::close(fd);
+        return ok;
+    }
+};
+
+// 超出资源预算时对进程采取的动作
+enum class SuppressAction {
+    THROTTLE,  // 降低调度优先级并移入后台 cpuset
+    FREEZE,    // 冻结进程，回到前台时解冻
+    KILL       // 直接杀死
+};
+
+inline SuppressAction parseSuppressAction(const std::string& name, SuppressAction fallback) {
+    if (name == "throttle") return SuppressAction::THROTTLE;
+    if (name == "freeze") return SuppressAction::FREEZE;
+    if (name == "kill") return SuppressAction::KILL;
+    return fallback;
+}
+
+inline const char* suppressActionName(SuppressAction action) noexcept {
+    switch (action) {
+        case SuppressAction::THROTTLE: return "throttle";
+        case SuppressAction::FREEZE: return "freeze";
+        case SuppressAction::KILL: return "kill";
+    }
+    return "unknown";
+}
+
+// 每个目标在 suppress_config.json 中可配置的资源预算
+struct TargetPolicy {
+    double cpu_budget_seconds{30.0};                    // 窗口内允许的后台CPU时间
+    std::chrono::seconds cpu_budget_window{std::chrono::minutes(10)};
+    SuppressAction cpu_budget_action{SuppressAction::THROTTLE};
+    double io_limit_kbps{0.0};                          // 后台存储读写速率上限，0 表示不限制
+    SuppressAction io_limit_action{SuppressAction::THROTTLE};
+    double net_limit_kbps{0.0};                         // 后台网络收发速率上限，0 表示不限制
+    SuppressAction net_limit_action{SuppressAction::THROTTLE};
+};
+
+// 一个压制目标的完整配置
+struct TargetConfig {
+    std::string package_name;
+    std::vector<std::string> process_names;
+    TargetPolicy policy;
+};
+
+// 令牌桶：容量为预算秒数，按 预算/窗口 的速率匀速补充
+struct CpuBudget {
+    double capacity{0.0};
+    double refill_per_second{0.0};
+    double tokens{0.0};
+    std::chrono::steady_clock::time_point last_refill;
+
+    void configure(double budget_seconds, std::chrono::seconds window) {
+        capacity = budget_seconds;
+        refill_per_second = window.count() > 0 ? budget_seconds / window.count() : 0.0;
+        reset(std::chrono::steady_clock::now());
+    }
+
+    void reset(std::chrono::steady_clock::time_point now) {
+        tokens = capacity;
+        last_refill = now;
+    }
+
+    // 调整容量但保留已消耗的额度，用于档位切换
+    void resize(double budget_seconds, std::chrono::seconds window) {
+        capacity = budget_seconds;
+        refill_per_second = window.count() > 0 ? budget_seconds / window.count() : 0.0;
+        tokens = std::clamp(tokens, -capacity, capacity);
+    }
+
+    // 扣除消耗的CPU秒数，允许欠账但不超过一个桶的容量
+    void consume(double cpu_seconds, std::chrono::steady_clock::time_point now) {
+        double elapsed = std::chrono::duration<double>(now - last_refill).count();
+        tokens = std::min(capacity, tokens + elapsed * refill_per_second);
+        tokens = std::max(-capacity, tokens - cpu_seconds);
+        last_refill = now;
+    }
+
+    bool exhausted() const { return capacity > 0 && tokens < 0; }
+};
+
+// 不杀死进程的抑制动作：降低优先级、冻结与解冻
+class ProcessActuator {
+public:
+    static bool throttle(pid_t pid) {
+        bool ok = SystemProbe::current().setNice(pid, 19);
+        writeValue(sysPath("/dev/cpuset/background/cgroup.procs"), std::to_string(pid));
+        return ok;
+    }
+
+    // 直接写 oom_score_adj 并调用 setpriority，代替 fork shell 执行 echo/renice
+    static bool setPriority(pid_t pid, int oom_score_adj, int nice_value) {
+        bool ok = writeValue(sysPath("/proc/" + std::to_string(pid) + "/oom_score_adj"), std::to_string(oom_score_adj));
+        return SystemProbe::current().setNice(pid, nice_value) && ok;
+    }
+
+    static bool freeze(pid_t pid) {
+        std::string cgroup_path = getCgroupV2Path(pid);
+        if (!cgroup_path.empty() && writeValue(sysPath("/sys/fs/cgroup" + cgroup_path + "/cgroup.freeze"), "1")) {
+            return true;
+        }
+        return SystemProbe::current().signal(pid, SIGSTOP);
+    }
+
+    // 先全部 SIGSTOP 再全部 SIGKILL，避免进程树中的父子进程在杀死过程中互相拉起
+    static int killAll(const std::vector<pid_t>& pids) {
+        auto& probe = SystemProbe::current();
+        for (pid_t pid : pids) {
+            probe.signal(pid, SIGSTOP);
+        }
+        int killed = 0;
+        for (pid_t pid : pids) {
+            if (probe.signal(pid, SIGKILL)) {
+                killed++;
+            }
+        }
+        return killed;
+    }
+
+    static bool thaw(pid_t pid) {
+        std::string cgroup_path = getCgroupV2Path(pid);
+        if (!cgroup_path.empty()) {
+            writeValue(sysPath("/sys/fs/cgroup" + cgroup_path + "/cgroup.freeze"), "0");
+        }
+        // 同时发送 SIGCONT，兼容以 SIGSTOP 冻结的进程
+        return SystemProbe::current().signal(pid, SIGCONT);
+    }
+
+private:
+    static bool writeValue(const std::string& path, const std::string& value) {
+        int fd = open(path.c_str(), O_WRONLY | O_CLOEXEC);
+        if (fd == -1) return false;
+        bool ok = write(fd, value.data(), value.size()) == static_cast<ssize_t>(value.size());
+        ::close(fd);
+        return ok;
+    }
+};
+
+// 确认一组进程已经退出：本机进程通过 pidfd 等待（须在发送信号前打开，避免 pid 被复用），
+// 夹具中的进程或不支持 pidfd 的内核退化为轮询 /proc/<pid> 是否消失
+class ExitWatch {
+public:
+    explicit ExitWatch(const std::vector<pid_t>& pids) {
+        bool host = SystemProbe::current().hostPids();
+        for (pid_t pid : pids) {
+            int pidfd = host ? static_cast<int>(syscall(SYS_pidfd_open, pid, 0)) : -1;
+            entries_.push_back({ pid, pidfd });
+        }
+    }
+
+    ~ExitWatch() { closeAll(); }
+
+    ExitWatch(ExitWatch&& other) noexcept : entries_(std::move(other.entries_)) { other.entries_.clear(); }
+    ExitWatch& operator=(ExitWatch&& other) noexcept {
+        if (this != &other) {
+            closeAll();
+            entries_ = std::move(other.entries_);
+            other.entries_.clear();
+        }
+        return *this;
+    }
+    ExitWatch(const ExitWatch&) = delete;
+    ExitWatch& operator=(const ExitWatch&) = delete;
+
+    // 轮询 /proc 的间隔（夹具或无 pidfd 时）
+    static constexpr int PROC_POLL_MS = 10;
+
+    // 移除已退出的进程，不阻塞；全部退出时返回 true
+    bool reap() {
+        std::vector<pollfd> fds;
+        for (auto it = entries_.begin(); it != entries_.end();) {
+            if (it->pidfd == -1 && access(sysPath("/proc/" + std::to_string(it->pid)).c_str(), F_OK) != 0) {
+                it = entries_.erase(it);
+                continue;
+            }
+            if (it->pidfd != -1) fds.push_back({ it->pidfd, POLLIN, 0 });
+            ++it;
+        }
+        if (!fds.empty() && poll(fds.data(), fds.size(), 0) > 0) {
+            for (const auto& fd : fds) {
+                if (fd.revents == 0) continue;
+                auto entry = std::find_if(entries_.begin(), entries_.end(),
+                    [&](const Entry& e) { return e.pidfd == fd.fd; });
+                ::close(entry->pidfd);
+                entries_.erase(entry);
+            }
+        }
+        return entries_.empty();
+    }
+
+    // 追加可供 poll 等待的 pidfd；仍有只能轮询 /proc 的进程时置位 needs_proc_polling
+    void addPollFds(std::vector<pollfd>& fds, bool& needs_proc_polling) const {
+        for (const auto& entry : entries_) {
+            if (entry.pidfd != -1) {
+                fds.push_back({ entry.pidfd, POLLIN, 0 });
+            } else {
+                needs_proc_polling = true;
+            }
+        }
+    }
+
+private:
+    struct Entry {
+        pid_t pid;
+        int pidfd;
+    };
+    std::vector<Entry> entries_;
+
+    void closeAll() {
+        for (const auto& entry : entries_) {
+            if (entry.pidfd != -1) ::close(entry.pidfd);
+        }
+    }
+};
+
+// 杀死确认线程：一次 poll 同时等待所有待确认杀死的 pidfd，退出或超时后读取可用内存。
+// 等待可长达数秒，放在独立线程中，不占用探测线程池；首次杀死时才创建线程
+class KillWatcher {
+public:
+    struct Outcome {
+        bool confirmed{ false };
+        double latency_ms{ 0.0 };
+        long long available_delta{ 0 };  // 退出前后 MemAvailable 的差值
+    };
+
+    KillWatcher() = default;
+    KillWatcher(const KillWatcher&) = delete;
+    KillWatcher& operator=(const KillWatcher&) = delete;
+
+    ~KillWatcher() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        wake();
+        if (worker_.joinable()) worker_.join();
+        if (event_fd_ != -1) ::close(event_fd_);
+    }
+
+    std::future<Outcome> watch(ExitWatch exits, std::chrono::steady_clock::time_point started,
+                               long long available_before, std::chrono::steady_clock::duration timeout) {
+        std::future<Outcome> result;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto& job = jobs_.emplace_back();
+            job.exits = std::move(exits);
+            job.started = started;
+            job.deadline = started + timeout;
+            job.available_before = available_before;
+            result = job.promise.get_future();
+            if (!worker_.joinable()) {
+                event_fd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+                worker_ = std::thread(&KillWatcher::run, this);
+            }
+        }
+        wake();
+        return result;
+    }
+
+private:
+    struct Job {
+        ExitWatch exits{ {} };
+        std::chrono::steady_clock::time_point started;
+        std::chrono::steady_clock::time_point deadline;
+        long long available_before{ -1 };
+        std::promise<Outcome> promise;
+    };
+
+    std::mutex mutex_;
+    std::vector<Job> jobs_;
+    bool stopping_{ false };
+    int event_fd_{ -1 };
+    std::thread worker_;
+
+    void wake() {
+        uint64_t value = 1;
+        if (event_fd_ != -1) write(event_fd_, &value, sizeof(value));
+    }
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stopping_) {
+            // 等到最早的超时、任一 pidfd 可读或有新任务加入
+            std::vector<pollfd> fds{ { event_fd_, POLLIN, 0 } };
+            bool needs_proc_polling = false;
+            int timeout_ms = -1;
+            auto now = std::chrono::steady_clock::now();
+            for (const auto& job : jobs_) {
+                job.exits.addPollFds(fds, needs_proc_polling);
+                auto remaining = std::chrono::ceil<std::chrono::milliseconds>(job.deadline - now).count();
+                int job_ms = static_cast<int>(std::clamp<int64_t>(remaining, 0, INT_MAX));
+                timeout_ms = timeout_ms < 0 ? job_ms : std::min(timeout_ms, job_ms);
+            }
+            if (needs_proc_polling) {
+                timeout_ms = timeout_ms < 0 ? ExitWatch::PROC_POLL_MS : std::min(timeout_ms, ExitWatch::PROC_POLL_MS);
+            }
+
+            lock.unlock();
+            poll(fds.data(), fds.size(), timeout_ms);
+            uint64_t value;
+            while (read(event_fd_, &value, sizeof(value)) > 0) {}
+            lock.lock();
+
+            now = std::chrono::steady_clock::now();
+            for (auto it = jobs_.begin(); it != jobs_.end();) {
+                bool confirmed = it->exits.reap();
+                if (!confirmed && now < it->deadline) {
+                    ++it;
+                    continue;
+                }
+                Outcome outcome;
+                outcome.confirmed = confirmed;
+                outcome.latency_ms = std::chrono::duration<double, std::milli>(now - it->started).count();
+                long long available_after = readMemAvailableBytes();
+                if (it->available_before >= 0 && available_after >= 0) {
+                    outcome.available_delta = available_after - it->available_before;
+                }
+                it->promise.set_value(outcome);
+                it = jobs_.erase(it);
+            }
+        }
+    }
+};
+
+// 以 2 的幂分桶的直方图：第 0 桶为 0，第 i 桶覆盖 [2^(i-1), 2^i)，末桶兜底。
+// 内存固定，分位数按所在桶的上界估计
+class Log2Histogram {
+public:
+    static constexpr size_t BUCKETS = 40;
+
+    void add(uint64_t value) {
+        size_t index = std::min<size_t>(std::bit_width(value), BUCKETS - 1);
+        buckets_[index]++;
+        count_++;
+        sum_ += value;
+        min_ = count_ == 1 ? value : std::min(min_, value);
+        max_ = std::max(max_, value);
+    }
+
+    uint64_t count() const { return count_; }
+    uint64_t sum() const { return sum_; }
+
+    uint64_t quantile(double q) const {
+        if (count_ == 0) return 0;
+        uint64_t rank = static_cast<uint64_t>(std::ceil(q * count_));
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BUCKETS; ++i) {
+            seen += buckets_[i];
+            if (seen >= std::max<uint64_t>(rank, 1)) {
+                uint64_t upper = i == 0 ? 0 : (uint64_t{1} << i) - 1;
+                return std::clamp(upper, min_, max_);
+            }
+        }
+        return max_;
+    }
+
+    nlohmann::json toJson() const {
+        return {
+            { "count", count_ },
+            { "min", count_ ? min_ : 0 },
+            { "p50", quantile(0.5) },
+            { "p95", quantile(0.95) },
+            { "max", max_ },
+            { "mean", count_ ? static_cast<double>(sum_) / count_ : 0.0 },
+        };
+    }
+
+private:
+    std::array<uint64_t, BUCKETS> buckets_{};
+    uint64_t count_{ 0 };
+    uint64_t sum_{ 0 };
+    uint64_t min_{ 0 };
+    uint64_t max_{ 0 };
+};
+
+// 每进程存储 I/O 与每 UID 网络流量计数
+class TrafficAccounting {
+public:
+    struct Counters {
+        unsigned long long read_bytes{0};
+        unsigned long long write_bytes{0};
+    };
+
+    // /proc/<pid>/io 中实际落到存储层的读写字节数
+    static bool readIoCounters(pid_t pid, Counters& out) {
+        std::string content = readProcFile(sysPath("/proc/" + std::to_string(pid) + "/io"));
+        size_t read_pos = content.find("\nread_bytes:");
+        size_t write_pos = content.find("\nwrite_bytes:");
+        if (read_pos == std::string::npos || write_pos == std::string::npos) return false;
+
+        out.read_bytes = strtoull(content.c_str() + read_pos + 12, nullptr, 10);
+        out.write_bytes = strtoull(content.c_str() + write_pos + 13, nullptr, 10);
+        return true;
+    }
+
+    // 按 UID 读取网络收发字节数（read_bytes 为接收，write_bytes 为发送）
+    static bool readUidNetCounters(long uid, Counters& out) {
+        if (readBpfUidCounters(uid, out)) return true;
+        // 旧内核的 uid_stat 接口
+        std::string base = sysPath("/proc/uid_stat/" + std::to_string(uid) + "/");
+        std::string rcv = readProcFile(base + "tcp_rcv");
+        std::string snd = readProcFile(base + "tcp_snd");
+        if (!rcv.empty() && !snd.empty()) {
+            out.read_bytes = strtoull(rcv.c_str(), nullptr, 10);
+            out.write_bytes = strtoull(snd.c_str(), nullptr, 10);
+            return true;
+        }
+        return readQtaguidCounters(uid, out);
+    }
+
+    // 进程位于独立网络命名空间时，其 /proc/<pid>/net/dev 只包含自身流量
+    static bool readPrivateNetnsCounters(pid_t pid, Counters& out) {
+        struct stat self_ns, proc_ns;
+        std::string ns_path = sysPath("/proc/" + std::to_string(pid) + "/ns/net");
+        if (stat(sysPath("/proc/self/ns/net").c_str(), &self_ns) != 0 || stat(ns_path.c_str(), &proc_ns) != 0 ||
+            self_ns.st_ino == proc_ns.st_ino) {
+            return false;
+        }
+        return readNetDevTotals(sysPath("/proc/" + std::to_string(pid) + "/net/dev"), out.read_bytes, out.write_bytes);
+    }
+
+private:
+    // netd 的 eBPF 统计值，字段顺序与 bpf_shared.h 中的 StatsValue 一致
+    struct BpfStatsValue {
+        uint64_t rx_packets;
+        uint64_t rx_bytes;
+        uint64_t tx_packets;
+        uint64_t tx_bytes;
+    };
+
+    // Android 10 起流量由 netd 的 eBPF 程序统计，app_uid_stats_map 以 UID 为键保存开机以来的收发字节
+    static bool readBpfUidCounters(long uid, Counters& out) {
+        static const int map_fd = openUidStatsMap();
+        if (map_fd < 0) return false;
+
+        uint32_t key = static_cast<uint32_t>(uid);
+        BpfStatsValue value{};
+        union bpf_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.map_fd = static_cast<uint32_t>(map_fd);
+        attr.key = reinterpret_cast<uint64_t>(&key);
+        attr.value = reinterpret_cast<uint64_t>(&value);
+        if (syscall(SYS_bpf, BPF_MAP_LOOKUP_ELEM, &attr, sizeof(attr)) != 0) {
+            // 没有条目说明该 UID 尚未产生流量
+            if (errno != ENOENT) return false;
+            value = {};
+        }
+        out.read_bytes = value.rx_bytes;
+        out.write_bytes = value.tx_bytes;
+        return true;
+    }
+
+    // 网络模块独立更新（Android 13+）后映射位于 netd_shared 目录下
+    static int openUidStatsMap() {
+        for (const char* path : { "/sys/fs/bpf/netd_shared/map_netd_app_uid_stats_map",
+                                  "/sys/fs/bpf/map_netd_app_uid_stats_map" }) {
+            std::string pinned = sysPath(path);
+            union bpf_attr attr;
+            memset(&attr, 0, sizeof(attr));
+            attr.pathname = reinterpret_cast<uint64_t>(pinned.c_str());
+            attr.file_flags = BPF_F_RDONLY;
+            int fd = static_cast<int>(syscall(SYS_bpf, BPF_OBJ_GET, &attr, sizeof(attr)));
+            if (fd >= 0) return fd;
+        }
+        return -1;
+    }
+
+    // xt_qtaguid 统计每行: idx iface acct_tag uid cnt_set rx_bytes rx_packets tx_bytes ...
+    static bool readQtaguidCounters(long uid, Counters& out) {
+        static std::mutex cache_mutex;
+        static std::string cache;
+        static std::chrono::steady_clock::time_point cache_time;
+
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        auto now = std::chrono::steady_clock::now();
+        if (now - cache_time > std::chrono::seconds(1)) {
+            cache = readProcFile(sysPath("/proc/net/xt_qtaguid/stats"));
+            cache_time = now;
+        }
+        if (cache.empty()) return false;
+
+        bool found = false;
+        out = {};
+        size_t line_start = cache.find('\n');
+        while (line_start != std::string::npos && line_start + 1 < cache.size()) {
+            const char* line = cache.c_str() + line_start + 1;
+            char iface[32];
+            unsigned long long tag, rx, tx;
+            long line_uid;
+            if (sscanf(line, "%*d %31s %llx %ld %*d %llu %*u %llu", iface, &tag, &line_uid, &rx, &tx) == 5 &&
+                tag == 0 && line_uid == uid && strcmp(iface, "lo") != 0) {
+                out.read_bytes += rx;
+                out.write_bytes += tx;
+                found = true;
+            }
+            line_start = cache.find('\n', line_start + 1);
+        }
+        return found;
+    }
+};
+
+// 屏幕状态探测接口，返回 std::nullopt 表示无法判断
+class ScreenStateProbe {
+public:
+    virtual ~ScreenStateProbe() = default;
+    virtual std::optional<bool> readScreenOn() = 0;
+    virtual const char* name() const = 0;
+};
+
+// 从 sysfs 背光节点读取屏幕状态，只需一次文件读取
+class BacklightScreenProbe : public ScreenStateProbe {
+public:
+    static std::unique_ptr<BacklightScreenProbe> create() {
+        std::vector<std::string> candidates;
+        std::string backlight_dir = sysPath("/sys/class/backlight");
+        if (DIR* dir = opendir(backlight_dir.c_str())) {
+            while (dirent* entry = readdir(dir)) {
+                if (entry->d_name[0] != '.') {
+                    candidates.push_back(backlight_dir + "/" + entry->d_name);
+                }
+            }
+            closedir(dir);
+        }
+        std::sort(candidates.begin(), candidates.end());
+        candidates.push_back(sysPath("/sys/class/leds/lcd-backlight"));
+
+        for (const auto& base : candidates) {
+            if (access((base + "/brightness").c_str(), R_OK) == 0) {
+                auto probe = std::unique_ptr<BacklightScreenProbe>(new BacklightScreenProbe());
+                probe->brightness_path_ = base + "/brightness";
+                if (access((base + "/bl_power").c_str(), R_OK) == 0) {
+                    probe->bl_power_path_ = base + "/bl_power";
+                }
+                if (probe->readScreenOn()) {
+                    return probe;
+                }
+            }
+        }
+        return nullptr;
+    }
+
+    std::optional<bool> readScreenOn() override {
+        // bl_power: 0 为 FB_BLANK_UNBLANK，其他值表示背光关闭
+        if (!bl_power_path_.empty()) {
+            std::string power = readProcFile(bl_power_path_);
+            if (!power.empty() && strtol(power.c_str(), nullptr, 10) != 0) {
+                return false;
+            }
+        }
+        std::string brightness = readProcFile(brightness_path_);
+        if (brightness.empty()) return std::nullopt;
+        return strtol(brightness.c_str(), nullptr, 10) > 0;
+    }
+
+    const char* name() const override { return "backlight"; }
+    const std::string& brightnessPath() const { return brightness_path_; }
+
+private:
+    BacklightScreenProbe() = default;
+    std::string brightness_path_;
+    std::string bl_power_path_;
+};
+
+// 回退方案：解析 dumpsys display 中的 mScreenState
+class DumpsysScreenProbe : public ScreenStateProbe {
+public:
+    std::optional<bool> readScreenOn() override {
+        std::string output = SystemProbe::current().run({ "dumpsys", "display" }, CommandRunner::stopAfter("mScreenState="));
+        
+        // 查找包含 "mScreenState=" 的行
+        const std::string target = "mScreenState=";
+        size_t pos = output.find(target);
+        if (pos == std::string::npos) {
+            Logger::log(Logger::Level::WARN, "Failed to find screen state in dumpsys display output");
+            return std::nullopt;
+        }
+        
+        // 获取状态值
+        pos += target.length();
+        size_t end = output.find('\n', pos);
+        if (end == std::string::npos) {
+            end = output.length();
+        }
+        
+        // 提取并比较状态值
+        std::string state = output.substr(pos, end - pos);
+        return state.find("ON") != std::string::npos;
+    }
+
+    const char* name() const override { return "dumpsys"; }
+};
+
+// 通过 epoll 监听 /dev/input/event* 记录最后一次用户交互时间，
+// 并在电源键、触摸或预计的息屏超时时刻重新读取背光状态，无需轮询。
+// 只监听按键、触摸与指针设备，距离/霍尔传感器、耳机插孔等开关类设备不算用户操作
+class UserActivityMonitor {
+public:
+    using ScreenChangeCallback = std::function<void(bool)>;
+
+    ~UserActivityMonitor() { stop(); }
+
+    bool start(ScreenStateProbe* probe, ScreenChangeCallback on_change) {
+        probe_ = probe;
+        on_change_ = std::move(on_change);
+        last_interaction_ns_ = nowNs();
+        if (probe_) {
+            screen_on_ = probe_->readScreenOn().value_or(true);
+        }
+
+        epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+        stop_fd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (epoll_fd_ == -1 || stop_fd_ == -1) {
+            stop();
+            return false;
+        }
+        addFd(stop_fd_, EPOLLIN);
+
+        std::string input_dir = sysPath("/dev/input");
+        if (DIR* dir = opendir(input_dir.c_str())) {
+            while (dirent* entry = readdir(dir)) {
+                if (strncmp(entry->d_name, "event", 5) != 0) continue;
+                std::string path = input_dir + "/" + entry->d_name;
+                int fd = open(path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+                if (fd == -1) continue;
+                if (!isInteractiveDevice(fd)) {
+                    ::close(fd);
+                    continue;
+                }
+                input_fds_.push_back(fd);
+                addFd(fd, EPOLLIN);
+            }
+            closedir(dir);
+        }
+        if (input_fds_.empty()) {
+            stop();
+            return false;
+        }
+
+        worker_ = std::thread(&UserActivityMonitor::run, this);
+        Logger::log(Logger::Level::INFO, std::format("User activity monitor watching {} input devices",
+            input_fds_.size()));
+        return true;
+    }
+
+    void stop() {
+        if (worker_.joinable()) {
+            uint64_t value = 1;
+            write(stop_fd_, &value, sizeof(value));
+            worker_.join();
+        }
+        for (int fd : input_fds_) ::close(fd);
+        input_fds_.clear();
+        if (epoll_fd_ != -1) ::close(epoll_fd_);
+        if (stop_fd_ != -1) ::close(stop_fd_);
+        epoll_fd_ = -1;
+        stop_fd_ = -1;
+    }
+
+    bool active() const { return worker_.joinable(); }
+
+    // 系统息屏超时（毫秒），用于在无输入事件时预测息屏时刻
+    void setScreenOffTimeout(std::chrono::milliseconds timeout) { screen_off_timeout_ms_ = timeout.count(); }
+
+    std::chrono::steady_clock::duration idleTime() const {
+        return std::chrono::nanoseconds(nowNs() - last_interaction_ns_.load());
+    }
+
+    bool screenOn() const { return screen_on_; }
+
+private:
+    static constexpr int RECHECK_DELAY_MS = 500;  // 电源键后背光变化的等待时间
+    static constexpr int RECHECK_ATTEMPTS = 4;
+    static constexpr int TIMEOUT_MARGIN_MS = 2000;
+
+    ScreenStateProbe* probe_{nullptr};
+    ScreenChangeCallback on_change_;
+    int epoll_fd_{-1};
+    int stop_fd_{-1};
+    std::vector<int> input_fds_;
+    std::thread worker_;
+    std::atomic<int64_t> last_interaction_ns_{0};
+    std::atomic<bool> screen_on_{true};
+    std::atomic<int64_t> screen_off_timeout_ms_{0};
+    int64_t deferred_check_ns_{0};  // 超时复查发现仍亮屏时推迟到的时刻，仅工作线程访问
+
+    static int64_t nowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    static bool isInteractionEvent(uint16_t type) {
+        return type == EV_KEY || type == EV_ABS || type == EV_REL;
+    }
+
+    // 通过 EVIOCGBIT 查询设备支持的事件类型，只保留能产生按键、绝对或相对坐标事件的设备
+    static bool isInteractiveDevice(int fd) {
+        constexpr size_t LONG_BITS = sizeof(unsigned long) * 8;
+        unsigned long types[(EV_MAX + LONG_BITS) / LONG_BITS] = {};
+        if (ioctl(fd, EVIOCGBIT(0, sizeof(types)), types) < 0) return false;
+        auto has = [&](unsigned type) { return (types[type / LONG_BITS] >> (type % LONG_BITS)) & 1UL; };
+        return has(EV_KEY) || has(EV_ABS) || has(EV_REL);
+    }
+
+    void addFd(int fd, uint32_t events) {
+        epoll_event ev{};
+        ev.events = events;
+        ev.data.fd = fd;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev);
+    }
+
+    void recheckScreen() {
+        if (!probe_) return;
+        auto state = probe_->readScreenOn();
+        if (state && *state != screen_on_) {
+            screen_on_ = *state;
+            if (on_change_) on_change_(*state);
+        }
+    }
+
+    // 计算下一次需要主动读取背光的等待时间，-1 表示无限等待
+    int nextTimeoutMs(int pending_rechecks) const {
+        if (pending_rechecks > 0) return RECHECK_DELAY_MS;
+        int64_t timeout_ms = screen_off_timeout_ms_;
+        if (!screen_on_ || timeout_ms <= 0) return -1;
+
+        int64_t deadline_ns = std::max(last_interaction_ns_ + (timeout_ms + TIMEOUT_MARGIN_MS) * 1000000,
+                                       deferred_check_ns_);
+        int64_t remaining = (deadline_ns - nowNs()) / 1000000;
+        return static_cast<int>(std::clamp<int64_t>(remaining, 0, INT_MAX));
+    }
+
+    void run() {
+        int pending_rechecks = 0;
+        epoll_event events[8];
+        input_event input_events[16];
+
+        while (true) {
+            int count = epoll_wait(epoll_fd_, events, 8, nextTimeoutMs(pending_rechecks));
+            if (count == -1) {
+                if (errno == EINTR) continue;
+                break;
+            }
+
+            if (count == 0) {
+                // 等待超时：电源键后的延迟复查或预计的息屏时刻
+                recheckScreen();
+                if (pending_rechecks > 0) {
+                    pending_rechecks--;
+                } else if (screen_on_) {
+                    // 仍然亮屏（例如应用保持常亮），推迟到下一个超时周期；不算作用户操作，空闲时长照常累计
+                    deferred_check_ns_ = nowNs() + (screen_off_timeout_ms_ + TIMEOUT_MARGIN_MS) * 1000000;
+                }
+                continue;
+            }
+
+            for (int i = 0; i < count; ++i) {
+                int fd = events[i].data.fd;
+                if (fd == stop_fd_) return;
+
+                bool power_key = false;
+                bool interaction = false;
+                ssize_t bytes;
+                while ((bytes = read(fd, input_events, sizeof(input_events))) > 0) {
+                    for (size_t j = 0; j < bytes / sizeof(input_event); ++j) {
+                        // EV_SYN/EV_MSC 等同步与附加信息不算用户操作
+                        if (!isInteractionEvent(input_events[j].type)) continue;
+                        interaction = true;
+                        if (input_events[j].type == EV_KEY && input_events[j].code == KEY_POWER) {
+                            power_key = true;
+                        }
                     }
-                    stats_json["hourly_usage"] = hourly_array;
-                    
-                    j["app_stats"][pkg] = stats_json;
                 }
-                
-                // 基本习惯信息
-                j["screen_on_duration_avg"] = habits.screen_on_duration_avg;
-                j["app_switch_frequency"] = habits.app_switch_frequency;
-                j["habit_samples"] = habits.habit_samples;
-                j["last_update"] = std::chrono::system_clock::to_time_t(habits.last_update);
-                j["last_full_save"] = std::chrono::system_clock::to_time_t(habits.last_full_save);
-                j["learning_weight"] = habits.learning_weight;
-                j["learning_hours"] = habits.learning_hours;
-                j["learning_complete"] = habits.learning_complete;
-                j["learning_intensity"] = static_cast<int>(learning_intensity);
-
-                // 保存每日模式
-                nlohmann::json patterns_array = nlohmann::json::array();
-                for (const auto& pattern : habits.daily_patterns) {
-                    nlohmann::json pattern_json;
-                    pattern_json["hour"] = pattern.hour;
-                    pattern_json["activity_level"] = pattern.activity_level;
-                    pattern_json["check_frequency"] = pattern.check_frequency;
-                    
-                    // 保存活跃应用列表
-                    nlohmann::json active_apps_array = nlohmann::json::array();
-                    for (const auto& app : pattern.active_apps) {
-                        active_apps_array.push_back(app);
+                if (!interaction) continue;
+                last_interaction_ns_ = nowNs();
+
+                // 电源键或息屏状态下的任何输入都可能点亮/关闭屏幕
+                if (power_key || !screen_on_) {
+                    pending_rechecks = RECHECK_ATTEMPTS;
+                }
+            }
+        }
+    }
+};
+
+// packages.list 索引：包名与应用 UID（appId）的映射，文件变化时通过 inotify 增量更新
+class PackageIndex {
+public:
+    static constexpr uid_t PER_USER_RANGE = 100000;
+    static constexpr uid_t FIRST_APPLICATION_UID = 10000;
+    static constexpr uid_t LAST_APPLICATION_UID = 19999;
+    static constexpr uid_t FIRST_APP_ZYGOTE_ISOLATED_UID = 90000;
+    static constexpr uid_t LAST_ISOLATED_UID = 99999;
+
+    ~PackageIndex() {
+        if (inotify_fd_ != -1) ::close(inotify_fd_);
+    }
+
+    void open(const std::string& path) {
+        path_ = path;
+        size_t slash = path_.rfind('/');
+        std::string dir = slash == std::string::npos ? "." : path_.substr(0, slash);
+        file_name_ = slash == std::string::npos ? path_ : path_.substr(slash + 1);
+
+        // packages.list 由 PackageManager 写临时文件后 rename 替换，需监听目录
+        inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (inotify_fd_ != -1 && inotify_add_watch(inotify_fd_, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) == -1) {
+            ::close(inotify_fd_);
+            inotify_fd_ = -1;
+        }
+        rebuild();
+    }
+
+    // 检查 inotify 事件，packages.list 变化时重建索引
+    void checkForUpdates() {
+        if (inotify_fd_ == -1) return;
+
+        alignas(inotify_event) char buffer[4096];
+        bool changed = false;
+        ssize_t length;
+        while ((length = read(inotify_fd_, buffer, sizeof(buffer))) > 0) {
+            for (char* ptr = buffer; ptr < buffer + length;) {
+                auto* event = reinterpret_cast<inotify_event*>(ptr);
+                if (event->len > 0 && file_name_ == event->name) {
+                    changed = true;
+                }
+                ptr += sizeof(inotify_event) + event->len;
+            }
+        }
+        if (changed) {
+            rebuild();
+        }
+    }
+
+    bool loaded() const { return !app_ids_.empty(); }
+
+    // 返回应用 UID 对应的包名（共享 UID 时可能有多个）
+    const std::vector<std::string>* packagesForAppId(uid_t app_id) const {
+        auto it = packages_by_app_id_.find(app_id);
+        return it != packages_by_app_id_.end() ? &it->second : nullptr;
+    }
+
+    bool contains(const std::string& package_name) const { return app_ids_.count(package_name) > 0; }
+
+private:
+    std::string path_;
+    std::string file_name_;
+    int inotify_fd_{-1};
+    std::map<std::string, uid_t> app_ids_;
+    std::map<uid_t, std::vector<std::string>> packages_by_app_id_;
+
+    // 通过 mmap 解析，每行格式: "<包名> <appId> <debuggable> <数据目录> <seinfo> <gids>"
+    void rebuild() {
+        int fd = ::open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd == -1) {
+            Logger::log(Logger::Level::WARN, "Failed to open package list: " + path_);
+            return;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0) {
+            ::close(fd);
+            return;
+        }
+        void* mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (mapped == MAP_FAILED) return;
+
+        std::string_view content(static_cast<const char*>(mapped), st.st_size);
+        std::map<std::string, uid_t> parsed;
+        size_t line_start = 0;
+        while (line_start < content.size()) {
+            size_t line_end = content.find('\n', line_start);
+            if (line_end == std::string_view::npos) line_end = content.size();
+            std::string_view line = content.substr(line_start, line_end - line_start);
+            line_start = line_end + 1;
+
+            size_t name_end = line.find(' ');
+            if (name_end == std::string_view::npos || name_end == 0) continue;
+            uid_t app_id = static_cast<uid_t>(strtoul(std::string(line.substr(name_end + 1, 16)).c_str(), nullptr, 10));
+            if (app_id == 0) continue;
+            parsed.emplace(std::string(line.substr(0, name_end)), app_id);
+        }
+        munmap(mapped, st.st_size);
+
+        // 只更新变化的条目
+        int added = 0, removed = 0, updated = 0;
+        for (auto it = app_ids_.begin(); it != app_ids_.end();) {
+            if (!parsed.count(it->first)) {
+                unlinkPackage(it->first, it->second);
+                it = app_ids_.erase(it);
+                removed++;
+            } else {
+                ++it;
+            }
+        }
+        for (const auto& [package_name, app_id] : parsed) {
+            auto it = app_ids_.find(package_name);
+            if (it == app_ids_.end()) {
+                app_ids_.emplace(package_name, app_id);
+                packages_by_app_id_[app_id].push_back(package_name);
+                added++;
+            } else if (it->second != app_id) {
+                unlinkPackage(package_name, it->second);
+                it->second = app_id;
+                packages_by_app_id_[app_id].push_back(package_name);
+                updated++;
+            }
+        }
+        if (added || removed || updated) {
+            Logger::log(Logger::Level::INFO, std::format("Package index updated: +{} -{} ~{} ({} packages)",
+                added, removed, updated, app_ids_.size()));
+        }
+    }
+
+    void unlinkPackage(const std::string& package_name, uid_t app_id) {
+        auto it = packages_by_app_id_.find(app_id);
+        if (it == packages_by_app_id_.end()) return;
+        auto& packages = it->second;
+        packages.erase(std::remove(packages.begin(), packages.end(), package_name), packages.end());
+        if (packages.empty()) packages_by_app_id_.erase(it);
+    }
+};
+
+// /proc 进程索引：一次遍历建立 PID 与进程名的映射，替代逐个 fork pidof
+class ProcessIndex {
+public:
+    // 进程的归属：按 UID 确定的包名与用户 ID（工作资料等多用户）
+    struct Owner {
+        std::string package_name;
+        uid_t user_id{0};
+        bool isolated{false};  // 进程名以包名开头的 isolated/app zygote 进程（如浏览器自带的沙箱渲染进程）
+    };
+
+    explicit ProcessIndex(const PackageIndex& packages) : packages_(packages) {}
+
+    void refresh() {
+        cmdlines_.clear();
+        pids_by_name_.clear();
+        owners_.clear();
+        pids_by_package_.clear();
+
+        std::string proc_dir = sysPath("/proc");
+        DIR* dir = opendir(proc_dir.c_str());
+        if (!dir) return;
+        bool host_pids = SystemProbe::current().hostPids();
+        while (dirent* entry = readdir(dir)) {
+            if (entry->d_name[0] < '0' || entry->d_name[0] > '9') continue;
+            pid_t pid = static_cast<pid_t>(strtol(entry->d_name, nullptr, 10));
+
+            // cmdline 以 NUL 分隔参数，进程名为第一个参数；内核线程为空
+            std::string cmdline = readProcFile(proc_dir + "/" + entry->d_name + "/cmdline");
+            size_t nul = cmdline.find('\0');
+            if (nul != std::string::npos) cmdline.resize(nul);
+            if (cmdline.empty()) continue;
+
+            // /proc/<pid> 目录的属主即进程 UID，无需读取 status；
+            // 夹具文件的属主是本机用户，改用录制的 status 中的 UID
+            long uid = -1;
+            struct stat st;
+            if (!host_pids) {
+                uid = readProcUid(pid);
+            } else if (fstatat(dirfd(dir), entry->d_name, &st, 0) == 0) {
+                uid = st.st_uid;
+            }
+            if (uid >= 0) {
+                Owner owner;
+                if (classify(static_cast<uid_t>(uid), cmdline, owner)) {
+                    pids_by_package_[owner.package_name].push_back(pid);
+                    owners_.emplace(pid, std::move(owner));
+                }
+            }
+
+            pids_by_name_[cmdline].push_back(pid);
+            cmdlines_.emplace(pid, std::move(cmdline));
+        }
+        closedir(dir);
+        last_refresh_ = std::chrono::steady_clock::now();
+    }
+
+    // 属于指定包、且进程名为 process_name 或其子进程（"process_name:xxx"）的所有用户下的进程
+    std::vector<pid_t> pidsOf(const std::string& package_name, const std::string& process_name) const {
+        if (!packages_.loaded()) return pidsOf(process_name);
+
+        std::vector<pid_t> result;
+        auto it = pids_by_package_.find(package_name);
+        if (it == pids_by_package_.end()) return result;
+        for (pid_t pid : it->second) {
+            const std::string& cmdline = cmdlines_.at(pid);
+            if (cmdline == process_name ||
+                (cmdline.size() > process_name.size() && cmdline.compare(0, process_name.size(), process_name) == 0 &&
+                 cmdline[process_name.size()] == ':')) {
+                result.push_back(pid);
+            }
+        }
+        return result;
+    }
+
+    // 归属于指定包的全部进程
+    std::vector<pid_t> pidsOfPackage(const std::string& package_name) const {
+        auto it = pids_by_package_.find(package_name);
+        return it != pids_by_package_.end() ? it->second : std::vector<pid_t>{};
+    }
+
+    const Owner* ownerOf(pid_t pid) const {
+        auto it = owners_.find(pid);
+        return it != owners_.end() ? &it->second : nullptr;
+    }
+
+    // 索引超过 max_age 未刷新时重新扫描
+    void ensureFresh(std::chrono::steady_clock::duration max_age = std::chrono::seconds(1)) {
+        if (std::chrono::steady_clock::now() - last_refresh_ > max_age) {
+            refresh();
+        }
+    }
+
+    std::vector<pid_t> pidsOf(const std::string& process_name) const {
+        auto it = pids_by_name_.find(process_name);
+        return it != pids_by_name_.end() ? it->second : std::vector<pid_t>{};
+    }
+
+    // 返回进程名，索引中不存在时直接读取（刷新后新启动的进程）
+    std::string cmdlineOf(pid_t pid) const {
+        auto it = cmdlines_.find(pid);
+        if (it != cmdlines_.end()) return it->second;
+
+        std::string cmdline = readProcFile(sysPath("/proc/" + std::to_string(pid) + "/cmdline"));
+        size_t nul = cmdline.find('\0');
+        if (nul != std::string::npos) cmdline.resize(nul);
+        return cmdline;
+    }
+
+    // 进程名形如 "com.tencent.mm:appbrand0"，冒号之前为包名
+    static std::string packageOf(const std::string& cmdline) {
+        return cmdline.substr(0, cmdline.find(':'));
+    }
+
+private:
+    const PackageIndex& packages_;
+    std::map<pid_t, std::string> cmdlines_;
+    std::map<std::string, std::vector<pid_t>> pids_by_name_;
+    std::map<pid_t, Owner> owners_;
+    std::map<std::string, std::vector<pid_t>> pids_by_package_;
+    std::chrono::steady_clock::time_point last_refresh_;
+
+    // 普通应用按 appId 查表；隔离进程（isolated、app zygote）没有独立的包，按进程名前缀归属
+    bool classify(uid_t uid, const std::string& cmdline, Owner& owner) const {
+        uid_t app_id = uid % PackageIndex::PER_USER_RANGE;
+        owner.user_id = uid / PackageIndex::PER_USER_RANGE;
+        std::string package_name = packageOf(cmdline);
+
+        if (app_id >= PackageIndex::FIRST_APPLICATION_UID && app_id <= PackageIndex::LAST_APPLICATION_UID) {
+            const auto* packages = packages_.packagesForAppId(app_id);
+            if (!packages || packages->empty()) return false;
+            // 共享 UID 时优先选择与进程名匹配的包
+            auto match = std::find(packages->begin(), packages->end(), package_name);
+            owner.package_name = match != packages->end() ? *match : packages->front();
+            return true;
+        }
+        if (app_id >= PackageIndex::FIRST_APP_ZYGOTE_ISOLATED_UID && app_id <= PackageIndex::LAST_ISOLATED_UID &&
+            packages_.contains(package_name)) {
+            owner.package_name = std::move(package_name);
+            owner.isolated = true;
+            return true;
+        }
+        return false;
+    }
+};
+
+// 通过 top-app cpuset 成员与 oom_score_adj 判断前台应用，无需 dumpsys window
+class ForegroundDetector {
+public:
+    explicit ForegroundDetector(ProcessIndex& index) : index_(index) {
+        for (const char* member_file : { "/dev/cpuset/top-app/cgroup.procs", "/dev/cpuset/top-app/tasks" }) {
+            std::string path = sysPath(member_file);
+            if (access(path.c_str(), R_OK) == 0) {
+                members_path_ = path;
+                break;
+            }
+        }
+    }
+
+    bool available() const { return !members_path_.empty(); }
+
+    // 重新读取 top-app 成员，只对其中的少量进程读取 oom_score_adj 和进程名
+    void refresh() {
+        foreground_packages_.clear();
+        std::string members = readProcFile(members_path_);
+        std::set<pid_t> seen;
+
+        size_t pos = 0;
+        while (pos < members.size()) {
+            size_t end = members.find('\n', pos);
+            if (end == std::string::npos) end = members.size();
+            pid_t pid = static_cast<pid_t>(strtol(members.c_str() + pos, nullptr, 10));
+            pos = end + 1;
+            if (pid <= 0 || !seen.insert(pid).second) continue;
+
+            // 前台应用的 oom_score_adj 为 0（FOREGROUND_APP_ADJ），常驻系统进程为负值
+            std::string adj = readProcFile(sysPath("/proc/" + std::to_string(pid) + "/oom_score_adj"));
+            if (adj.empty() || strtol(adj.c_str(), nullptr, 10) != 0) continue;
+
+            std::string cmdline = index_.cmdlineOf(pid);
+            if (!cmdline.empty()) {
+                foreground_packages_.insert(ProcessIndex::packageOf(cmdline));
+            }
+        }
+    }
+
+    bool isForeground(const std::string& package_name) const {
+        return foreground_packages_.count(package_name) > 0;
+    }
+
+    const std::set<std::string>& foregroundPackages() const { return foreground_packages_; }
+
+private:
+    ProcessIndex& index_;
+    std::string members_path_;
+    std::set<std::string> foreground_packages_;
+};
+
+// suppress_config.json 预编译的二进制缓存：按源文件大小、mtime 与内容哈希校验，
+// 未变化时直接 mmap 读取，省去启动时的 JSON 解析与 argv 传参
+class ConfigCache {
+public:
+    // 读取配置，缓存失效时从 JSON 重新编译并写回
+    static std::vector<TargetConfig> load(const std::string& json_path) {
+        std::string cache_path = cachePathFor(json_path);
+        struct stat st;
+        if (stat(json_path.c_str(), &st) != 0) {
+            Logger::log(Logger::Level::ERROR, "Config file not found: " + json_path);
+            return {};
+        }
+        int64_t mtime_ns = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+
+        std::vector<TargetConfig> targets;
+        uint64_t cached_hash = 0;
+        if (readCache(cache_path, st.st_size, mtime_ns, targets, cached_hash)) {
+            Logger::log(Logger::Level::INFO, std::format("Loaded {} targets from config cache", targets.size()));
+            return targets;
+        }
+
+        std::string content = readProcFile(json_path);
+        uint64_t hash = fnv1a64(content.data(), content.size());
+        // 仅 mtime 变化而内容相同时沿用缓存内容，只刷新时间戳
+        if (cached_hash != 0 && cached_hash == hash && !targets.empty()) {
+            writeCache(cache_path, targets, st.st_size, mtime_ns, hash);
+            return targets;
+        }
+
+        targets = parseJson(content);
+        writeCache(cache_path, targets, st.st_size, mtime_ns, hash);
+        Logger::log(Logger::Level::INFO, std::format("Compiled {} targets into config cache", targets.size()));
+        return targets;
+    }
+
+    static std::vector<TargetConfig> parseJson(const std::string& content) {
+        std::vector<TargetConfig> targets;
+        try {
+            auto j = nlohmann::json::parse(content);
+            if (!j.contains("suppress_apps") || !j["suppress_apps"].is_object()) {
+                return targets;
+            }
+
+            for (auto& [package_name, app_json] : j["suppress_apps"].items()) {
+                if (!app_json.is_object() || !app_json.value("enabled", false)) continue;
+
+                TargetConfig config;
+                config.package_name = package_name;
+                if (app_json.contains("processes") && app_json["processes"].is_array()) {
+                    for (const auto& process : app_json["processes"]) {
+                        if (process.is_string() && !process.get<std::string>().empty()) {
+                            config.process_names.push_back(process.get<std::string>());
+                        }
+                    }
+                }
+                if (config.package_name.empty() || config.process_names.empty()) {
+                    Logger::log(Logger::Level::WARN, "Skipping invalid config entry: " + package_name);
+                    continue;
+                }
+
+                TargetPolicy& policy = config.policy;
+                if (app_json.contains("cpu_budget") && app_json["cpu_budget"].is_object()) {
+                    const auto& budget_json = app_json["cpu_budget"];
+                    policy.cpu_budget_seconds = budget_json.value("seconds", policy.cpu_budget_seconds);
+                    policy.cpu_budget_window = std::chrono::minutes(budget_json.value("window_minutes",
+                        static_cast<int>(std::chrono::duration_cast<std::chrono::minutes>(policy.cpu_budget_window).count())));
+                    policy.cpu_budget_action = parseSuppressAction(budget_json.value("action", std::string()),
+                        policy.cpu_budget_action);
+                }
+                if (app_json.contains("io_limit") && app_json["io_limit"].is_object()) {
+                    policy.io_limit_kbps = app_json["io_limit"].value("kbps", 0.0);
+                    policy.io_limit_action = parseSuppressAction(
+                        app_json["io_limit"].value("action", std::string()), policy.io_limit_action);
+                }
+                if (app_json.contains("net_limit") && app_json["net_limit"].is_object()) {
+                    policy.net_limit_kbps = app_json["net_limit"].value("kbps", 0.0);
+                    policy.net_limit_action = parseSuppressAction(
+                        app_json["net_limit"].value("action", std::string()), policy.net_limit_action);
+                }
+                targets.push_back(std::move(config));
+            }
+        } catch (const std::exception& e) {
+            Logger::log(Logger::Level::ERROR, std::format("Failed to parse config: {}", e.what()));
+        }
+        return targets;
+    }
+
+    static uint64_t fnv1a64(const void* data, size_t size) {
+        const auto* bytes = static_cast<const uint8_t*>(data);
+        uint64_t hash = 1469598103934665603ULL;
+        for (size_t i = 0; i < size; ++i) {
+            hash = (hash ^ bytes[i]) * 1099511628211ULL;
+        }
+        return hash;
+    }
+
+    static uint32_t checksum(const void* data, size_t size) {
+        uint64_t hash = fnv1a64(data, size);
+        return static_cast<uint32_t>(hash ^ (hash >> 32));
+    }
+
+private:
+    static constexpr uint32_t MAGIC = 0x43435344;  // "DSCC"
+    static constexpr uint32_t VERSION = 1;
+
+    struct Header {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t source_size;
+        int64_t source_mtime_ns;
+        uint64_t source_hash;
+        uint32_t target_count;
+        uint32_t process_count;
+        uint32_t strings_size;
+        uint32_t checksum;  // Header 之后全部数据的 FNV-1a
+    };
+
+    // 字符串以 (偏移, 长度) 引用字符串表，因此包名可以包含任意字符
+    struct StringRef {
+        uint32_t offset;
+        uint32_t length;
+    };
+
+    struct TargetRecord {
+        StringRef package_name;
+        uint32_t first_process;
+        uint32_t process_count;
+        float cpu_budget_seconds;
+        uint32_t cpu_budget_window_seconds;
+        float io_limit_kbps;
+        float net_limit_kbps;
+        uint8_t cpu_budget_action;
+        uint8_t io_limit_action;
+        uint8_t net_limit_action;
+        uint8_t reserved;
+    };
+
+    static std::string cachePathFor(const std::string& json_path) {
+        size_t dot = json_path.rfind('.');
+        size_t slash = json_path.rfind('/');
+        if (dot != std::string::npos && (slash == std::string::npos || dot > slash)) {
+            return json_path.substr(0, dot) + ".bin";
+        }
+        return json_path + ".bin";
+    }
+
+    // 缓存与源文件匹配时填充 targets 并返回 true；缓存有效但源文件已变化时只返回其内容哈希
+    static bool readCache(const std::string& cache_path, uint64_t source_size, int64_t mtime_ns,
+                          std::vector<TargetConfig>& targets, uint64_t& cached_hash) {
+        int fd = open(cache_path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd == -1) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(Header)) {
+            ::close(fd);
+            return false;
+        }
+        size_t size = st.st_size;
+        void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (mapped == MAP_FAILED) return false;
+
+        const auto* base = static_cast<const uint8_t*>(mapped);
+        Header header;
+        memcpy(&header, base, sizeof(header));
+
+        size_t targets_size = static_cast<size_t>(header.target_count) * sizeof(TargetRecord);
+        size_t processes_size = static_cast<size_t>(header.process_count) * sizeof(StringRef);
+        bool valid = header.magic == MAGIC && header.version == VERSION &&
+            size == sizeof(Header) + targets_size + processes_size + header.strings_size &&
+            header.checksum == checksum(base + sizeof(Header), size - sizeof(Header));
+
+        if (valid) {
+            cached_hash = header.source_hash;
+            const auto* records = reinterpret_cast<const TargetRecord*>(base + sizeof(Header));
+            const auto* processes = reinterpret_cast<const StringRef*>(base + sizeof(Header) + targets_size);
+            const char* strings = reinterpret_cast<const char*>(base + sizeof(Header) + targets_size + processes_size);
+            auto in_bounds = [&](const StringRef& ref) {
+                return ref.offset <= header.strings_size && ref.length <= header.strings_size - ref.offset;
+            };
+
+            for (uint32_t i = 0; valid && i < header.target_count; ++i) {
+                const TargetRecord& record = records[i];
+                if (!in_bounds(record.package_name) || record.first_process > header.process_count ||
+                    record.process_count > header.process_count - record.first_process) {
+                    valid = false;
+                    break;
+                }
+                TargetConfig config;
+                config.package_name.assign(strings + record.package_name.offset, record.package_name.length);
+                for (uint32_t p = 0; p < record.process_count; ++p) {
+                    const StringRef& ref = processes[record.first_process + p];
+                    if (!in_bounds(ref)) {
+                        valid = false;
+                        break;
+                    }
+                    config.process_names.emplace_back(strings + ref.offset, ref.length);
+                }
+                config.policy.cpu_budget_seconds = record.cpu_budget_seconds;
+                config.policy.cpu_budget_window = std::chrono::seconds(record.cpu_budget_window_seconds);
+                config.policy.cpu_budget_action = static_cast<SuppressAction>(record.cpu_budget_action);
+                config.policy.io_limit_kbps = record.io_limit_kbps;
+                config.policy.io_limit_action = static_cast<SuppressAction>(record.io_limit_action);
+                config.policy.net_limit_kbps = record.net_limit_kbps;
+                config.policy.net_limit_action = static_cast<SuppressAction>(record.net_limit_action);
+                targets.push_back(std::move(config));
+            }
+        }
+        munmap(mapped, size);
+
+        if (!valid) {
+            Logger::log(Logger::Level::WARN, "Config cache is corrupt, rebuilding");
+            targets.clear();
+            cached_hash = 0;
+            return false;
+        }
+        return header.source_size == source_size && header.source_mtime_ns == mtime_ns;
+    }
+
+    static void writeCache(const std::string& cache_path, const std::vector<TargetConfig>& targets,
+                           uint64_t source_size, int64_t mtime_ns, uint64_t source_hash) {
+        std::vector<TargetRecord> records;
+        std::vector<StringRef> processes;
+        std::string strings;
+        auto add_string = [&strings](const std::string& value) {
+            StringRef ref{ static_cast<uint32_t>(strings.size()), static_cast<uint32_t>(value.size()) };
+            strings += value;
+            return ref;
+        };
+
+        for (const auto& config : targets) {
+            TargetRecord record{};
+            record.package_name = add_string(config.package_name);
+            record.first_process = static_cast<uint32_t>(processes.size());
+            record.process_count = static_cast<uint32_t>(config.process_names.size());
+            for (const auto& process_name : config.process_names) {
+                processes.push_back(add_string(process_name));
+            }
+            record.cpu_budget_seconds = static_cast<float>(config.policy.cpu_budget_seconds);
+            record.cpu_budget_window_seconds = static_cast<uint32_t>(config.policy.cpu_budget_window.count());
+            record.io_limit_kbps = static_cast<float>(config.policy.io_limit_kbps);
+            record.net_limit_kbps = static_cast<float>(config.policy.net_limit_kbps);
+            record.cpu_budget_action = static_cast<uint8_t>(config.policy.cpu_budget_action);
+            record.io_limit_action = static_cast<uint8_t>(config.policy.io_limit_action);
+            record.net_limit_action = static_cast<uint8_t>(config.policy.net_limit_action);
+            records.push_back(record);
+        }
+
+        std::string blob(sizeof(Header), '\0');
+        blob.append(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(TargetRecord));
+        blob.append(reinterpret_cast<const char*>(processes.data()), processes.size() * sizeof(StringRef));
+        blob += strings;
+
+        Header header{};
+        header.magic = MAGIC;
+        header.version = VERSION;
+        header.source_size = source_size;
+        header.source_mtime_ns = mtime_ns;
+        header.source_hash = source_hash;
+        header.target_count = static_cast<uint32_t>(records.size());
+        header.process_count = static_cast<uint32_t>(processes.size());
+        header.strings_size = static_cast<uint32_t>(strings.size());
+        header.checksum = checksum(blob.data() + sizeof(Header), blob.size() - sizeof(Header));
+        memcpy(blob.data(), &header, sizeof(header));
+
+        // 先写临时文件再 rename，避免中断时留下半个缓存
+        std::string tmp_path = cache_path + ".tmp";
+        int fd = open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd == -1) {
+            Logger::log(Logger::Level::WARN, "Failed to write config cache: " + tmp_path);
+            return;
+        }
+        bool ok = write(fd, blob.data(), blob.size()) == static_cast<ssize_t>(blob.size()) && fsync(fd) == 0;
+        ::close(fd);
+        if (!ok || rename(tmp_path.c_str(), cache_path.c_str()) != 0) {
+            unlink(tmp_path.c_str());
+            Logger::log(Logger::Level::WARN, "Failed to write config cache: " + cache_path);
+        }
+    }
+};
+
+// 单个目标的资源时间序列（固定内存）：原始样本保留约1小时，
+// 5分钟 min/avg/max 桶保留1天，1小时桶保留1周
+class ResourceSeries {
+public:
+    struct Sample {
+        uint32_t time;  // Unix 秒
+        uint32_t memory_kb;
+        uint16_t cpu_percent;
+        uint16_t reserved;
+    };
+
+    struct Bucket {
+        uint32_t start;
+        uint32_t memory_min;
+        uint32_t memory_avg;
+        uint32_t memory_max;
+        uint16_t cpu_min;
+        uint16_t cpu_avg;
+        uint16_t cpu_max;
+        uint16_t count;
+    };
+
+    // 内存增长趋势（最小二乘斜率）
+    struct Trend {
+        double kb_per_hour{ 0.0 };
+        double r2{ 0.0 };
+        size_t samples{ 0 };
+    };
+
+    static constexpr uint32_t RAW_SPAN = 3600;
+    static constexpr size_t RAW_CAPACITY = 128;   // 30秒一次约覆盖1小时
+    static constexpr uint32_t DAY_BUCKET = 300;
+    static constexpr size_t DAY_CAPACITY = 288;
+    static constexpr uint32_t WEEK_BUCKET = 3600;
+    static constexpr size_t WEEK_CAPACITY = 168;
+
+    void add(uint32_t time, uint32_t memory_kb, uint16_t cpu_percent) {
+        uint32_t bucket_start = time - time % DAY_BUCKET;
+        if (five_minute_.count > 0 && five_minute_.start != bucket_start) {
+            closeFiveMinute();
+        }
+        if (five_minute_.count == 0) {
+            five_minute_.reset(bucket_start);
+        }
+        five_minute_.add(memory_kb, memory_kb, memory_kb, cpu_percent, cpu_percent, cpu_percent, 1);
+        raw_.push({ time, memory_kb, cpu_percent, 0 });
+    }
+
+    // 最近一小时原始样本的内存趋势
+    Trend memoryTrend(uint32_t now) const {
+        Trend trend;
+        double sum_t = 0, sum_m = 0, sum_tt = 0, sum_tm = 0, sum_mm = 0;
+        raw_.forEach([&](const Sample& sample) {
+            if (sample.time + RAW_SPAN < now || sample.memory_kb == 0) return;
+            double t = (static_cast<double>(sample.time) - now) / 3600.0;
+            double m = sample.memory_kb;
+            sum_t += t; sum_m += m; sum_tt += t * t; sum_tm += t * m; sum_mm += m * m;
+            trend.samples++;
+        });
+        if (trend.samples < 3) return trend;
+        double n = static_cast<double>(trend.samples);
+        double var_t = sum_tt - sum_t * sum_t / n;
+        double var_m = sum_mm - sum_m * sum_m / n;
+        double cov = sum_tm - sum_t * sum_m / n;
+        if (var_t <= 0.0) return trend;
+        trend.kb_per_hour = cov / var_t;
+        trend.r2 = var_m > 0.0 ? (cov * cov) / (var_t * var_m) : 0.0;
+        return trend;
+    }
+
+    // 持续且稳定的内存增长视为泄漏：斜率超过 20MB/h 或当前用量的 10%/h
+    bool leaking(uint32_t now, uint32_t current_kb) const {
+        auto trend = memoryTrend(now);
+        double threshold = std::max(LEAK_MIN_KB_PER_HOUR, current_kb * 0.1);
+        return trend.samples >= LEAK_MIN_SAMPLES && trend.r2 >= LEAK_MIN_R2 && trend.kb_per_hour >= threshold;
+    }
+
+    // range: "hour" 原始样本，"day" 5分钟桶，"week" 1小时桶
+    nlohmann::json toJson(const std::string& range) const {
+        nlohmann::json points = nlohmann::json::array();
+        if (range == "hour") {
+            raw_.forEach([&](const Sample& sample) {
+                points.push_back({ sample.time, sample.memory_kb, sample.cpu_percent });
+            });
+            return { { "columns", { "time", "memory_kb", "cpu_percent" } }, { "points", points } };
+        }
+        auto add_bucket = [&points](const Bucket& bucket) {
+            points.push_back({ bucket.start, bucket.memory_min, bucket.memory_avg, bucket.memory_max,
+                bucket.cpu_min, bucket.cpu_avg, bucket.cpu_max, bucket.count });
+        };
+        if (range == "week") {
+            week_.forEach(add_bucket);
+            if (hour_.count > 0) add_bucket(hour_.bucket());
+        } else {
+            day_.forEach(add_bucket);
+        }
+        if (five_minute_.count > 0 && range != "week") add_bucket(five_minute_.bucket());
+        return { { "columns", { "start", "memory_min_kb", "memory_avg_kb", "memory_max_kb",
+            "cpu_min", "cpu_avg", "cpu_max", "samples" } }, { "points", points } };
+    }
+
+    void serialize(std::string& out) const {
+        raw_.serialize(out);
+        day_.serialize(out);
+        week_.serialize(out);
+        appendPod(out, five_minute_);
+        appendPod(out, hour_);
+    }
+
+    bool deserialize(const char*& cursor, const char* end) {
+        return raw_.deserialize(cursor, end) && day_.deserialize(cursor, end) && week_.deserialize(cursor, end) &&
+               readPod(cursor, end, five_minute_) && readPod(cursor, end, hour_);
+    }
+
+private:
+    static constexpr double LEAK_MIN_KB_PER_HOUR = 20.0 * 1024;
+    static constexpr size_t LEAK_MIN_SAMPLES = 20;
+    static constexpr double LEAK_MIN_R2 = 0.8;
+
+    template <typename T, size_t N>
+    struct Ring {
+        std::array<T, N> items{};
+        uint16_t head{ 0 };  // 下一个写入位置
+        uint16_t size{ 0 };
+
+        void push(const T& item) {
+            items[head] = item;
+            head = static_cast<uint16_t>((head + 1) % N);
+            if (size < N) size++;
+        }
+
+        // 按时间顺序遍历
+        template <typename F>
+        void forEach(F&& visit) const {
+            for (size_t i = 0; i < size; ++i) {
+                visit(items[(head + N - size + i) % N]);
+            }
+        }
+
+        void serialize(std::string& out) const {
+            appendPod(out, size);
+            forEach([&out](const T& item) { appendPod(out, item); });
+        }
+
+        bool deserialize(const char*& cursor, const char* end) {
+            uint16_t count = 0;
+            if (!readPod(cursor, end, count) || count > N) return false;
+            head = 0;
+            size = 0;
+            for (uint16_t i = 0; i < count; ++i) {
+                T item;
+                if (!readPod(cursor, end, item)) return false;
+                push(item);
+            }
+            return true;
+        }
+    };
+
+    // 尚未结束的桶
+    struct Accumulator {
+        uint32_t start{ 0 };
+        uint32_t count{ 0 };
+        uint32_t memory_min{ 0 };
+        uint32_t memory_max{ 0 };
+        uint64_t memory_sum{ 0 };
+        uint32_t cpu_sum{ 0 };
+        uint16_t cpu_min{ 0 };
+        uint16_t cpu_max{ 0 };
+
+        void reset(uint32_t bucket_start) {
+            *this = Accumulator{};
+            start = bucket_start;
+        }
+
+        void add(uint32_t mem_min, uint32_t mem_avg, uint32_t mem_max,
+                 uint16_t c_min, uint16_t c_avg, uint16_t c_max, uint32_t samples) {
+            memory_min = count == 0 ? mem_min : std::min(memory_min, mem_min);
+            memory_max = count == 0 ? mem_max : std::max(memory_max, mem_max);
+            cpu_min = count == 0 ? c_min : std::min(cpu_min, c_min);
+            cpu_max = count == 0 ? c_max : std::max(cpu_max, c_max);
+            memory_sum += static_cast<uint64_t>(mem_avg) * samples;
+            cpu_sum += static_cast<uint32_t>(c_avg) * samples;
+            count += samples;
+        }
+
+        Bucket bucket() const {
+            return { start, memory_min, static_cast<uint32_t>(count ? memory_sum / count : 0), memory_max,
+                cpu_min, static_cast<uint16_t>(count ? cpu_sum / count : 0), cpu_max,
+                static_cast<uint16_t>(std::min<uint32_t>(count, 0xFFFF)) };
+        }
+    };
+
+    Ring<Sample, RAW_CAPACITY> raw_;
+    Ring<Bucket, DAY_CAPACITY> day_;
+    Ring<Bucket, WEEK_CAPACITY> week_;
+    Accumulator five_minute_;
+    Accumulator hour_;
+
+    void closeFiveMinute() {
+        Bucket bucket = five_minute_.bucket();
+        day_.push(bucket);
+        uint32_t hour_start = bucket.start - bucket.start % WEEK_BUCKET;
+        if (hour_.count > 0 && hour_.start != hour_start) {
+            week_.push(hour_.bucket());
+            hour_.count = 0;
+        }
+        if (hour_.count == 0) {
+            hour_.reset(hour_start);
+        }
+        hour_.add(bucket.memory_min, bucket.memory_avg, bucket.memory_max,
+                  bucket.cpu_min, bucket.cpu_avg, bucket.cpu_max, bucket.count);
+        five_minute_.count = 0;
+    }
+
+    template <typename T>
+    static void appendPod(std::string& out, const T& value) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template <typename T>
+    static bool readPod(const char*& cursor, const char* end, T& value) {
+        if (static_cast<size_t>(end - cursor) < sizeof(T)) return false;
+        memcpy(&value, cursor, sizeof(T));
+        cursor += sizeof(T);
+        return true;
+    }
+};
+
+// 时间序列持久化：二进制文件，按包名保存各目标的序列，整体 FNV 校验
+class ResourceHistoryFile {
+public:
+    static bool save(const std::string& path, const std::vector<std::pair<std::string, const ResourceSeries*>>& series) {
+        std::string blob(sizeof(Header), '\0');
+        for (const auto& [name, data] : series) {
+            uint16_t length = static_cast<uint16_t>(std::min<size_t>(name.size(), 0xFFFF));
+            blob.append(reinterpret_cast<const char*>(&length), sizeof(length));
+            blob.append(name.data(), length);
+            data->serialize(blob);
+        }
+        Header header{ MAGIC, VERSION, static_cast<uint32_t>(series.size()),
+            ConfigCache::checksum(blob.data() + sizeof(Header), blob.size() - sizeof(Header)) };
+        memcpy(blob.data(), &header, sizeof(header));
+
+        // 先写临时文件再 rename
+        std::string tmp_path = path + ".tmp";
+        int fd = open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd == -1) {
+            Logger::log(Logger::Level::WARN, "Failed to write resource history: " + tmp_path);
+            return false;
+        }
+        bool ok = write(fd, blob.data(), blob.size()) == static_cast<ssize_t>(blob.size()) && fsync(fd) == 0;
+        ::close(fd);
+        if (!ok || rename(tmp_path.c_str(), path.c_str()) != 0) {
+            unlink(tmp_path.c_str());
+            Logger::log(Logger::Level::WARN, "Failed to write resource history: " + path);
+            return false;
+        }
+        return true;
+    }
+
+    static std::map<std::string, ResourceSeries> load(const std::string& path) {
+        std::map<std::string, ResourceSeries> result;
+        std::string content = readProcFile(path);
+        if (content.size() < sizeof(Header)) return result;
+
+        Header header;
+        memcpy(&header, content.data(), sizeof(header));
+        if (header.magic != MAGIC || header.version != VERSION ||
+            header.checksum != ConfigCache::checksum(content.data() + sizeof(Header), content.size() - sizeof(Header))) {
+            Logger::log(Logger::Level::WARN, "Ignoring invalid resource history: " + path);
+            return result;
+        }
+
+        const char* cursor = content.data() + sizeof(Header);
+        const char* end = content.data() + content.size();
+        for (uint32_t i = 0; i < header.count; ++i) {
+            uint16_t length = 0;
+            if (static_cast<size_t>(end - cursor) < sizeof(length)) break;
+            memcpy(&length, cursor, sizeof(length));
+            cursor += sizeof(length);
+            if (static_cast<size_t>(end - cursor) < length) break;
+            std::string name(cursor, length);
+            cursor += length;
+            ResourceSeries series;
+            if (!series.deserialize(cursor, end)) break;
+            result.emplace(std::move(name), std::move(series));
+        }
+        return result;
+    }
+
+private:
+    static constexpr uint32_t MAGIC = 0x53545344;  // "DSTS"
+    static constexpr uint32_t VERSION = 1;
+
+    struct Header {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t count;
+        uint32_t checksum;
+    };
+};
+
+// 共享内存状态页：固定布局的 mmap 文件，守护进程用 seqlock 发布运行状态，
+// 读者（--status、WebUI）直接读取，无需 IPC 也不会唤醒守护进程
+class StatusPage {
+public:
+    static constexpr uint32_t MAGIC = 0x54534453;  // "DSST"
+    static constexpr uint16_t VERSION = 2;
+    static constexpr uint32_t MAX_TARGETS = 64;
+    static constexpr size_t NAME_SIZE = 128;
+
+    struct Header {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t header_size;
+        uint32_t target_record_size;
+        uint32_t target_capacity;
+        uint32_t sequence;  // seqlock：奇数表示正在写入
+        uint32_t target_count;
+        int32_t pid;
+        int32_t learning_hours;
+        uint8_t learning_intensity;
+        uint8_t screen_on;
+        uint8_t profile;  // SuppressionProfile
+        uint8_t policy;   // PolicyKind
+        uint32_t wakeups_last_hour;
+        int64_t start_time;   // Unix 秒
+        int64_t update_time;  // Unix 毫秒
+        uint64_t total_check_cycles;
+        uint64_t total_wakeups;
+        uint64_t total_processes_killed;
+        uint64_t total_bytes_freed;
+        uint64_t total_bytes_reclaimed;
+        uint64_t total_budget_enforcements;
+        uint64_t total_traffic_enforcements;
+        uint64_t commands_spawned;
+        uint64_t command_timeouts;
+        uint64_t habit_saves;
+        double avg_check_duration_ms;
+        double habit_save_avg_ms;
+    };
+
+    struct TargetStatus {
+        char package_name[NAME_SIZE];
+        uint8_t foreground;
+        uint8_t frozen;
+        uint8_t sticky;
+        uint8_t budget_enforced;
+        uint8_t traffic_enforced;
+        uint8_t memory_reclaimed;
+        uint8_t reserved[2];
+        int32_t oom_adj_score;
+        int32_t nice_value;
+        int32_t cpu_usage_percent;
+        int32_t memory_usage_kb;
+        int32_t kill_count;
+        uint32_t check_interval_s;
+        uint32_t kill_interval_s;
+        uint32_t reclaim_interval_s;
+        int64_t background_seconds;  // 前台时为 -1
+        uint64_t freed_bytes;
+        uint64_t reclaimed_bytes;
+        // 动作效果分布：杀死从执行到确认退出的延迟、可用内存增量与杀死前的 PSS
+        uint32_t kills_measured;
+        uint32_t kills_unconfirmed;  // 超时仍未退出
+        uint32_t kill_latency_p50_ms;
+        uint32_t kill_latency_p95_ms;
+        uint32_t kill_freed_p50_kb;
+        uint32_t kill_pss_p50_kb;
+        uint32_t reclaims_measured;
+        uint32_t reclaim_p50_kb;
+        double kill_effectiveness;  // 可用内存增量之和 / PSS 之和，未测量时为 -1
+        double io_read_rate;
+        double io_write_rate;
+        double net_rx_rate;
+        double net_tx_rate;
+    };
+
+    static_assert(std::is_trivially_copyable_v<Header> && std::is_trivially_copyable_v<TargetStatus>);
+    static constexpr size_t FILE_SIZE = sizeof(Header) + sizeof(TargetStatus) * MAX_TARGETS;
+
+    StatusPage() = default;
+    StatusPage(const StatusPage&) = delete;
+    StatusPage& operator=(const StatusPage&) = delete;
+
+    ~StatusPage() {
+        if (base_) {
+            munmap(base_, FILE_SIZE);
+        }
+    }
+
+    bool open(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (fd == -1) {
+            Logger::log(Logger::Level::WARN, std::format("Failed to open status page {}: {}", path, strerror(errno)));
+            return false;
+        }
+        if (ftruncate(fd, FILE_SIZE) != 0) {
+            ::close(fd);
+            return false;
+        }
+        void* mapped = mmap(nullptr, FILE_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (mapped == MAP_FAILED) {
+            return false;
+        }
+        base_ = static_cast<char*>(mapped);
+        memset(base_, 0, FILE_SIZE);
+        Header* header = this->header();
+        header->magic = MAGIC;
+        header->version = VERSION;
+        header->header_size = sizeof(Header);
+        header->target_record_size = sizeof(TargetStatus);
+        header->target_capacity = MAX_TARGETS;
+        header->pid = getpid();
+        return true;
+    }
+
+    bool active() const { return base_ != nullptr; }
+
+    // 写入端：beginUpdate 与 endUpdate 之间修改 header() 与 target()
+    void beginUpdate() {
+        uint32_t sequence = __atomic_load_n(&header()->sequence, __ATOMIC_RELAXED);
+        __atomic_store_n(&header()->sequence, sequence + 1, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+    }
+
+    void endUpdate() {
+        uint32_t sequence = __atomic_load_n(&header()->sequence, __ATOMIC_RELAXED);
+        __atomic_store_n(&header()->sequence, sequence + 1, __ATOMIC_RELEASE);
+    }
+
+    Header* header() { return reinterpret_cast<Header*>(base_); }
+    TargetStatus* target(size_t index) {
+        return reinterpret_cast<TargetStatus*>(base_ + sizeof(Header)) + index;
+    }
+
+    static void setName(TargetStatus& status, const std::string& name) {
+        size_t length = std::min(name.size(), NAME_SIZE - 1);
+        memcpy(status.package_name, name.data(), length);
+        status.package_name[length] = '\0';
+    }
+
+    // 读取端：取一致快照并转换为 JSON，失败返回 nullopt
+    static std::optional<nlohmann::json> read(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd == -1) return std::nullopt;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(Header)) {
+            ::close(fd);
+            return std::nullopt;
+        }
+        size_t size = st.st_size;
+        void* mapped = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (mapped == MAP_FAILED) return std::nullopt;
+        const char* base = static_cast<const char*>(mapped);
+        const auto* shared = reinterpret_cast<const Header*>(base);
+
+        Header header;
+        std::vector<TargetStatus> targets;
+        bool consistent = false;
+        for (int attempt = 0; attempt < 1000 && !consistent; ++attempt) {
+            uint32_t before = __atomic_load_n(&shared->sequence, __ATOMIC_ACQUIRE);
+            if (before & 1) {
+                sched_yield();
+                continue;
+            }
+            memcpy(&header, shared, sizeof(Header));
+            if (header.magic != MAGIC || header.version != VERSION ||
+                header.target_record_size != sizeof(TargetStatus) ||
+                sizeof(Header) + static_cast<size_t>(header.target_capacity) * sizeof(TargetStatus) > size) {
+                break;
+            }
+            targets.resize(std::min(header.target_count, header.target_capacity));
+            memcpy(targets.data(), base + sizeof(Header), targets.size() * sizeof(TargetStatus));
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            consistent = __atomic_load_n(&shared->sequence, __ATOMIC_RELAXED) == before;
+        }
+        munmap(mapped, size);
+        if (!consistent) return std::nullopt;
+
+        static constexpr const char* INTENSITY_NAMES[] = { "HIGH", "MEDIUM", "LOW", "STABLE" };
+        nlohmann::json j;
+        j["version"] = header.version;
+        j["pid"] = header.pid;
+        j["running"] = header.pid > 0 && kill(header.pid, 0) == 0;
+        j["start_time"] = header.start_time;
+        j["update_time_ms"] = header.update_time;
+        j["screen_on"] = header.screen_on != 0;
+        j["profile"] = profileName(static_cast<SuppressionProfile>(header.profile));
+        j["policy"] = policyName(static_cast<PolicyKind>(header.policy));
+        j["learning"] = {
+            { "hours", header.learning_hours },
+            { "intensity", header.learning_intensity < 4 ? INTENSITY_NAMES[header.learning_intensity] : "UNKNOWN" },
+        };
+        j["stats"] = {
+            { "check_cycles", header.total_check_cycles },
+            { "wakeups", header.total_wakeups },
+            { "wakeups_last_hour", header.wakeups_last_hour },
+            { "avg_check_duration_ms", header.avg_check_duration_ms },
+            { "processes_killed", header.total_processes_killed },
+            { "bytes_freed", header.total_bytes_freed },
+            { "bytes_reclaimed", header.total_bytes_reclaimed },
+            { "budget_enforcements", header.total_budget_enforcements },
+            { "traffic_enforcements", header.total_traffic_enforcements },
+            { "commands_spawned", header.commands_spawned },
+            { "command_timeouts", header.command_timeouts },
+            { "habit_saves", header.habit_saves },
+            { "habit_save_avg_ms", header.habit_save_avg_ms },
+        };
+        nlohmann::json targets_json = nlohmann::json::array();
+        for (const auto& target : targets) {
+            targets_json.push_back({
+                { "package", std::string(target.package_name, strnlen(target.package_name, NAME_SIZE)) },
+                { "foreground", target.foreground != 0 },
+                { "frozen", target.frozen != 0 },
+                { "sticky", target.sticky != 0 },
+                { "budget_enforced", target.budget_enforced != 0 },
+                { "traffic_enforced", target.traffic_enforced != 0 },
+                { "memory_reclaimed", target.memory_reclaimed != 0 },
+                { "oom_adj_score", target.oom_adj_score },
+                { "nice", target.nice_value },
+                { "cpu_percent", target.cpu_usage_percent },
+                { "memory_kb", target.memory_usage_kb },
+                { "kills", target.kill_count },
+                { "freed_bytes", target.freed_bytes },
+                { "reclaimed_bytes", target.reclaimed_bytes },
+                { "kill_outcomes", {
+                    { "measured", target.kills_measured },
+                    { "unconfirmed", target.kills_unconfirmed },
+                    { "latency_p50_ms", target.kill_latency_p50_ms },
+                    { "latency_p95_ms", target.kill_latency_p95_ms },
+                    { "freed_p50_kb", target.kill_freed_p50_kb },
+                    { "pss_p50_kb", target.kill_pss_p50_kb },
+                    { "effectiveness", target.kill_effectiveness },
+                } },
+                { "reclaim_outcomes", {
+                    { "measured", target.reclaims_measured },
+                    { "reclaimed_p50_kb", target.reclaim_p50_kb },
+                } },
+                { "check_interval_s", target.check_interval_s },
+                { "kill_interval_s", target.kill_interval_s },
+                { "reclaim_interval_s", target.reclaim_interval_s },
+                { "background_seconds", target.background_seconds },
+                { "io_read_bps", target.io_read_rate },
+                { "io_write_bps", target.io_write_rate },
+                { "net_rx_bps", target.net_rx_rate },
+                { "net_tx_bps", target.net_tx_rate },
+            });
+        }
+        j["targets"] = targets_json;
+        return j;
+    }
+
+private:
+    char* base_{ nullptr };
+};
+
+// 单个目标的处理动作，决策阶段产生、执行阶段应用，也写入运行轨迹
+enum class TargetAction : uint8_t { NONE, ENFORCE_CPU_BUDGET, ENFORCE_TRAFFIC, KILL, RECLAIM, ADJUST_PRIORITY };
+
+inline const char* actionName(TargetAction action) {
+    switch (action) {
+        case TargetAction::ENFORCE_CPU_BUDGET: return "enforce_cpu_budget";
+        case TargetAction::ENFORCE_TRAFFIC: return "enforce_traffic";
+        case TargetAction::KILL: return "kill";
+        case TargetAction::RECLAIM: return "reclaim";
+        case TargetAction::ADJUST_PRIORITY: return "adjust_priority";
+        default: return "none";
+    }
+}
+
+// 运行轨迹记录器：把探测结果与决策按时间写成紧凑的二进制记录，超过大小上限时轮转，
+// 用于离线复现现场行为。包名首次出现时写一条 NAME 记录，之后以编号引用。
+// 记录头 12 字节，逐字段写入、无填充：int64 Unix 毫秒、uint8 类型、uint8 保留、uint16 负载长度
+class TraceRecorder {
+public:
+    static constexpr uint32_t MAGIC = 0x52545344;  // "DSTR"
+    static constexpr uint16_t VERSION = 2;          // 版本 1 的记录头含 4 字节对齐填充
+    static constexpr size_t DEFAULT_MAX_BYTES = 4 * 1024 * 1024;
+    static constexpr size_t FLUSH_THRESHOLD = 8192;
+    static constexpr auto MAX_BUFFER_AGE = std::chrono::seconds(60);  // 记录在内存中最多停留的时间
+    static constexpr size_t RECORD_HEADER_SIZE = 12;
+
+    enum class Type : uint8_t { NAME = 1, SCREEN, FOREGROUND, SAMPLE, DECISION, POWER };
+
+    struct FileHeader {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t reserved;
+        int64_t created_ms;
+    };
+
+    // 记录头之后紧跟 length 字节的负载
+    struct RecordHeader {
+        int64_t time_ms;  // Unix 毫秒
+        uint8_t type;
+        uint16_t length;
+    };
+
+    ~TraceRecorder() { close(); }
+
+    bool open(const std::string& path, size_t max_bytes) {
+        path_ = path;
+        max_bytes_ = std::max<size_t>(max_bytes, 64 * 1024);
+        if (!startFile()) return false;
+        Logger::log(Logger::Level::INFO, std::format("Recording trace to {} (max {}KB per file)", path_, max_bytes_ / 1024));
+        return true;
+    }
+
+    bool active() const { return fd_ != -1; }
+
+    void screen(bool on) {
+        if (!active()) return;
+        begin(Type::SCREEN);
+        put<uint8_t>(on ? 1 : 0);
+        end();
+    }
+
+    // 前台集合只在变化时记录
+    void foreground(const std::set<std::string>& packages) {
+        if (!active() || packages == last_foreground_) return;
+        last_foreground_ = packages;
+        std::vector<uint16_t> ids;
+        for (const auto& package : packages) ids.push_back(nameId(package));
+        begin(Type::FOREGROUND);
+        put<uint16_t>(ids.size());
+        for (uint16_t id : ids) put(id);
+        end();
+    }
+
+    void sample(const std::string& package, int memory_kb, int cpu_percent,
+                double io_read_rate, double io_write_rate, double net_rx_rate, double net_tx_rate) {
+        if (!active()) return;
+        uint16_t id = nameId(package);
+        begin(Type::SAMPLE);
+        put(id);
+        put<uint32_t>(std::max(0, memory_kb));
+        put<uint16_t>(std::clamp(cpu_percent, 0, 0xFFFF));
+        for (double rate : { io_read_rate, io_write_rate, net_rx_rate, net_tx_rate }) {
+            put<float>(rate / 1024.0);  // KB/s
+        }
+        end();
+    }
+
+    void decision(const std::string& package, TargetAction enforcement, TargetAction maintenance,
+                  int64_t background_seconds, int64_t kill_interval_seconds) {
+        if (!active()) return;
+        uint16_t id = nameId(package);
+        begin(Type::DECISION);
+        put(id);
+        put(static_cast<uint8_t>(enforcement));
+        put(static_cast<uint8_t>(maintenance));
+        put<int32_t>(std::clamp<int64_t>(background_seconds, -1, INT32_MAX));
+        put<int32_t>(std::clamp<int64_t>(kill_interval_seconds, 0, INT32_MAX));
+        end();
+    }
+
+    void power(const PowerState& state, SuppressionProfile profile) {
+        if (!active()) return;
+        begin(Type::POWER);
+        put<int8_t>(state.battery_level);
+        put<uint8_t>(state.charging ? 1 : 0);
+        put(static_cast<uint8_t>(profile));
+        put<int16_t>(std::isnan(state.battery_temp_c) ? INT16_MIN : static_cast<int16_t>(state.battery_temp_c * 10));
+        put<int16_t>(std::isnan(state.max_thermal_c) ? INT16_MIN : static_cast<int16_t>(state.max_thermal_c * 10));
+        end();
+    }
+
+    // 每批任务结束时调用；缓冲不足阈值且未超过停留时间时继续积攒，减少写入次数
+    void flush(bool force = false) {
+        if (!active() || buffer_.empty()) return;
+        if (!force && buffer_.size() < FLUSH_THRESHOLD && flushDelay() > std::chrono::steady_clock::duration::zero()) return;
+        if (write(fd_, buffer_.data(), buffer_.size()) != static_cast<ssize_t>(buffer_.size())) {
+            Logger::log(Logger::Level::WARN, std::format("Trace write failed: {}", strerror(errno)));
+        }
+        file_size_ += buffer_.size();
+        buffer_.clear();
+        // 缓冲中的记录引用当前文件的包名编号，写完再轮转
+        if (file_size_ >= max_bytes_) rotate();
+    }
+
+    // 距最早一条未写入记录达到停留上限的剩余时间；缓冲为空时返回 std::nullopt
+    std::optional<std::chrono::steady_clock::duration> flushDelay() const {
+        if (!active() || buffer_.empty()) return std::nullopt;
+        return std::max<std::chrono::steady_clock::duration>(std::chrono::steady_clock::duration::zero(),
+            first_buffered_ + MAX_BUFFER_AGE - std::chrono::steady_clock::now());
+    }
+
+    void close() {
+        flush(true);
+        if (fd_ != -1) ::close(fd_);
+        fd_ = -1;
+    }
+
+    struct DumpFilter {
+        std::string package;
+        std::string type;
+        int64_t since_ms{ INT64_MIN };
+        int64_t until_ms{ INT64_MAX };
+    };
+
+    // 按时间顺序输出轮转文件与当前文件中的记录，每行一个 JSON
+    static int dump(const std::string& path, const DumpFilter& filter) {
+        size_t total = 0;
+        bool found = false;
+        for (const auto& file : { path + ".1", path }) {
+            std::string content = readProcFile(file);
+            if (content.size() < sizeof(FileHeader)) continue;
+            FileHeader header;
+            memcpy(&header, content.data(), sizeof(header));
+            if (header.magic != MAGIC || header.version != VERSION) {
+                fprintf(stderr, "Skipping %s: not a trace file\n", file.c_str());
+                continue;
+            }
+            found = true;
+            total += dumpFile(content, filter);
+        }
+        if (!found) {
+            fprintf(stderr, "No readable trace at %s\n", path.c_str());
+            return 1;
+        }
+        fprintf(stderr, "%zu records\n", total);
+        return 0;
+    }
+
+private:
+    std::string path_;
+    size_t max_bytes_{ DEFAULT_MAX_BYTES };
+    int fd_{ -1 };
+    size_t file_size_{ 0 };
+    std::string buffer_;
+    std::chrono::steady_clock::time_point first_buffered_;
+    size_t record_start_{ 0 };
+    std::map<std::string, uint16_t> names_;
+    std::set<std::string> last_foreground_;
+
+    static int64_t nowMs() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    template <typename T>
+    void put(T value) {
+        buffer_.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    void begin(Type type) {
+        if (buffer_.empty()) first_buffered_ = std::chrono::steady_clock::now();
+        record_start_ = buffer_.size();
+        put<int64_t>(nowMs());
+        put(static_cast<uint8_t>(type));
+        put<uint8_t>(0);
+        put<uint16_t>(0);  // 负载长度，在 end() 中回填
+    }
+
+    void end() {
+        auto length = static_cast<uint16_t>(buffer_.size() - record_start_ - RECORD_HEADER_SIZE);
+        memcpy(buffer_.data() + record_start_ + RECORD_HEADER_SIZE - sizeof(length), &length, sizeof(length));
+    }
+
+    static RecordHeader readRecordHeader(const char* data) {
+        RecordHeader record;
+        memcpy(&record.time_ms, data, sizeof(record.time_ms));
+        record.type = static_cast<uint8_t>(data[8]);
+        memcpy(&record.length, data + 10, sizeof(record.length));
+        return record;
+    }
+
+    uint16_t nameId(const std::string& name) {
+        auto it = names_.find(name);
+        if (it != names_.end()) return it->second;
+        auto id = static_cast<uint16_t>(names_.size());
+        names_.emplace(name, id);
+        auto length = static_cast<uint16_t>(std::min<size_t>(name.size(), 0xFFFF));
+        begin(Type::NAME);
+        put(id);
+        buffer_.append(name, 0, length);
+        end();
+        return id;
+    }
+
+    bool startFile() {
+        fd_ = ::open(path_.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd_ == -1) {
+            Logger::log(Logger::Level::WARN, std::format("Cannot open trace file {}: {}", path_, strerror(errno)));
+            return false;
+        }
+        FileHeader header{ MAGIC, VERSION, 0, nowMs() };
+        write(fd_, &header, sizeof(header));
+        file_size_ = sizeof(header);
+        return true;
+    }
+
+    // 保留一个旧文件；新文件重新声明包名，并重放当前前台集合
+    void rotate() {
+        ::close(fd_);
+        rename(path_.c_str(), (path_ + ".1").c_str());
+        names_.clear();
+        auto foreground = std::move(last_foreground_);
+        last_foreground_.clear();
+        if (startFile()) this->foreground(foreground);
+    }
+
+    static size_t dumpFile(const std::string& content, const DumpFilter& filter) {
+        static const char* TYPE_NAMES[] = { "", "name", "screen", "foreground", "sample", "decision", "power" };
+        std::map<uint16_t, std::string> names;
+        auto nameOf = [&](uint16_t id) {
+            auto it = names.find(id);
+            return it != names.end() ? it->second : std::format("#{}", id);
+        };
+
+        size_t count = 0;
+        size_t offset = sizeof(FileHeader);
+        while (offset + RECORD_HEADER_SIZE <= content.size()) {
+            RecordHeader record = readRecordHeader(content.data() + offset);
+            offset += RECORD_HEADER_SIZE;
+            if (offset + record.length > content.size()) break;  // 末尾写入不完整
+            const char* payload = content.data() + offset;
+            offset += record.length;
+
+            auto get = [&](auto& value, size_t& pos) {
+                if (pos + sizeof(value) <= record.length) memcpy(&value, payload + pos, sizeof(value));
+                pos += sizeof(value);
+            };
+            size_t pos = 0;
+            auto type = static_cast<Type>(record.type);
+            if (type == Type::NAME) {
+                uint16_t id = 0;
+                get(id, pos);
+                names[id] = std::string(payload + pos, record.length - std::min<size_t>(pos, record.length));
+                continue;
+            }
+            if (record.type == 0 || record.type >= std::size(TYPE_NAMES)) continue;
+
+            nlohmann::json j = { { "t", record.time_ms }, { "type", TYPE_NAMES[record.type] } };
+            std::string package;
+            switch (type) {
+                case Type::SCREEN: {
+                    uint8_t on = 0;
+                    get(on, pos);
+                    j["on"] = on != 0;
+                    break;
+                }
+                case Type::FOREGROUND: {
+                    uint16_t size = 0;
+                    get(size, pos);
+                    nlohmann::json packages = nlohmann::json::array();
+                    for (uint16_t i = 0; i < size; ++i) {
+                        uint16_t id = 0;
+                        get(id, pos);
+                        packages.push_back(nameOf(id));
+                        if (nameOf(id) == filter.package) package = filter.package;
                     }
-                    pattern_json["active_apps"] = active_apps_array;
-                    
-                    patterns_array.push_back(pattern_json);
+                    j["packages"] = packages;
+                    break;
                 }
-                j["daily_patterns"] = patterns_array;
-                
-                // 清除修改记录
-                habits.clearModifiedApps();
-            } else {
-                // 增量保存 - 只保存修改的数据
-                j["save_version"] = habits.save_version;  // 使用相同的版本号
-                j["incremental"] = true;
-                j["timestamp"] = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
-                
-                // 保存修改的应用统计
-                for (const auto& [pkg, stats] : habits.modified_stats) {
-                    nlohmann::json stats_json;
-                    
-                    stats_json["usage_count"] = stats.usage_count;
-                    stats_json["total_foreground_time"] = stats.total_foreground_time;
-                    stats_json["total_background_time"] = stats.total_background_time;
-                    stats_json["switch_count"] = stats.switch_count;
-                    stats_json["importance_weight"] = stats.importance_weight;
-                    stats_json["last_usage_hour"] = stats.last_usage_hour;
-                    stats_json["last_used_day"] = stats.last_used_day;
-                    stats_json["consecutive_days_used"] = stats.consecutive_days_used;
-                    stats_json["usage_pattern_score"] = stats.usage_pattern_score;
-                    
-                    j["modified_apps"][pkg] = stats_json;
+                case Type::SAMPLE: {
+                    uint16_t id = 0, cpu = 0;
+                    uint32_t memory = 0;
+                    float rates[4] = {};
+                    get(id, pos);
+                    get(memory, pos);
+                    get(cpu, pos);
+                    for (auto& rate : rates) get(rate, pos);
+                    package = nameOf(id);
+                    j["package"] = package;
+                    j["memory_kb"] = memory;
+                    j["cpu_percent"] = cpu;
+                    j["io_kbps"] = { rates[0], rates[1] };
+                    j["net_kbps"] = { rates[2], rates[3] };
+                    break;
                 }
-                
-                // 更新基本信息
-                j["screen_on_duration_avg"] = habits.screen_on_duration_avg;
-                j["app_switch_frequency"] = habits.app_switch_frequency;
-                j["habit_samples"] = habits.habit_samples;
-                j["learning_hours"] = habits.learning_hours;
-                j["learning_weight"] = habits.learning_weight;
-                j["learning_complete"] = habits.learning_complete;
-                
-                // 清除当前修改记录
-                habits.clearModifiedApps();
+                case Type::DECISION: {
+                    uint16_t id = 0;
+                    uint8_t enforcement = 0, maintenance = 0;
+                    int32_t background = 0, kill_interval = 0;
+                    get(id, pos);
+                    get(enforcement, pos);
+                    get(maintenance, pos);
+                    get(background, pos);
+                    get(kill_interval, pos);
+                    package = nameOf(id);
+                    j["package"] = package;
+                    j["enforcement"] = actionName(static_cast<TargetAction>(enforcement));
+                    j["maintenance"] = actionName(static_cast<TargetAction>(maintenance));
+                    j["background_s"] = background;
+                    j["kill_interval_s"] = kill_interval;
+                    break;
+                }
+                case Type::POWER: {
+                    int8_t level = 0;
+                    uint8_t charging = 0, profile = 0;
+                    int16_t battery_temp = 0, thermal = 0;
+                    get(level, pos);
+                    get(charging, pos);
+                    get(profile, pos);
+                    get(battery_temp, pos);
+                    get(thermal, pos);
+                    j["battery_level"] = level;
+                    j["charging"] = charging != 0;
+                    j["profile"] = profileName(static_cast<SuppressionProfile>(profile));
+                    if (battery_temp != INT16_MIN) j["battery_temp_c"] = battery_temp / 10.0;
+                    if (thermal != INT16_MIN) j["thermal_c"] = thermal / 10.0;
+                    break;
+                }
+                default:
+                    break;
+            }
+
+            if (record.time_ms < filter.since_ms || record.time_ms > filter.until_ms) continue;
+            if (!filter.type.empty() && filter.type != TYPE_NAMES[record.type]) continue;
+            if (!filter.package.empty() && package != filter.package) continue;
+            printf("%s\n", j.dump().c_str());
+            count++;
+        }
+        return count;
+    }
+};
+
+// CLOCK_BOOTTIME 时钟：深睡眠期间继续计时，Doze 中的周期任务不会被无限推迟
+struct BootClock {
+    using duration = std::chrono::nanoseconds;
+    using rep = duration::rep;
+    using period = duration::period;
+    using time_point = std::chrono::time_point<BootClock>;
+    static constexpr bool is_steady = true;
+
+    static time_point now() noexcept {
+        timespec ts{};
+        clock_gettime(CLOCK_BOOTTIME, &ts);
+        return time_point(std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec));
+    }
+};
+
+// 截止时间合并调度器：每个任务给出 [最早, 最晚] 执行窗口，调度器只在最早到期的
+// 截止时间唤醒一次，并顺带执行所有窗口已开启的任务，把多个周期性工作合并为一次唤醒
+class WakeupScheduler {
+public:
+    using Clock = BootClock;
+    using TaskId = size_t;
+
+    WakeupScheduler() {
+        epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+        timer_fd_ = timerfd_create(CLOCK_BOOTTIME, TFD_CLOEXEC | TFD_NONBLOCK);
+        event_fd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (epoll_fd_ != -1) {
+            addFd(timer_fd_);
+            addFd(event_fd_);
+        }
+    }
+
+    ~WakeupScheduler() {
+        for (int fd : { epoll_fd_, timer_fd_, event_fd_ }) {
+            if (fd != -1) ::close(fd);
+        }
+    }
+
+    WakeupScheduler(const WakeupScheduler&) = delete;
+    WakeupScheduler& operator=(const WakeupScheduler&) = delete;
+
+    TaskId add(std::string name, std::function<void()> run) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& task = tasks_.emplace_back();
+        task.name = std::move(name);
+        task.run = std::move(run);
+        return tasks_.size() - 1;
+    }
+
+    // 在 [now + delay, now + delay + slack] 内执行；已排期的任务以新窗口为准
+    void schedule(TaskId id, Clock::duration delay, Clock::duration slack) {
+        auto earliest = Clock::now() + delay;
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto& task = tasks_[id];
+        task.pending = true;
+        task.earliest = earliest;
+        task.latest = earliest + slack;
+    }
+
+    void cancel(TaskId id) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_[id].pending = false;
+    }
+
+    bool scheduled(TaskId id) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return tasks_[id].pending;
+    }
+
+    // 线程安全：立即执行任务（例如屏幕状态变化的回调）
+    void runSoon(TaskId id) {
+        schedule(id, Clock::duration::zero(), Clock::duration::zero());
+        interrupt();
+    }
+
+    // 唤醒 runOnce，不安排任何任务（用于退出）
+    void interrupt() {
+        uint64_t value = 1;
+        if (event_fd_ != -1) write(event_fd_, &value, sizeof(value));
+    }
+
+    // 供信号处理函数直接写入的唤醒 eventfd
+    int wakeFd() const { return event_fd_; }
+
+    // 等待下一批任务的截止时间并执行所有窗口已开启的任务，返回本次执行的任务数
+    size_t runOnce() {
+        waitForDeadline();
+
+        auto now = Clock::now();
+        std::vector<TaskId> due;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (TaskId id = 0; id < tasks_.size(); ++id) {
+                auto& task = tasks_[id];
+                if (task.pending && task.earliest <= now) {
+                    task.pending = false;
+                    task.runs++;
+                    due.push_back(id);
+                }
+            }
+            wakeups_++;
+            tasks_run_ += due.size();
+            recent_wakeups_.push_back(now);
+            while (!recent_wakeups_.empty() && now - recent_wakeups_.front() > std::chrono::hours(1)) {
+                recent_wakeups_.pop_front();
+            }
+        }
+        // 任务可能重新安排自身，执行时不持锁；tasks_ 只在启动阶段追加，元素地址保持不变
+        for (TaskId id : due) {
+            try {
+                tasks_[id].run();
+            } catch (const std::exception& e) {
+                Logger::log(Logger::Level::ERROR, std::format("Error in task {}: {}", tasks_[id].name, e.what()));
+                // 出错的任务来不及重新排期，稍后重试
+                if (!scheduled(id)) schedule(id, ERROR_RETRY_DELAY, ERROR_RETRY_DELAY);
             }
-
-            std::string json_str = j.dump(4);
-            write(fd, json_str.c_str(), json_str.length());
-            fsync(fd);
-            Logger::log(Logger::Level::INFO, full_save ? 
-                "User habits saved successfully (full save)" : 
-                "User habits updated incrementally");
-        } catch (const std::exception& e) {
-            Logger::log(Logger::Level::ERROR, std::format("Failed to save user habits: {}", e.what()));
         }
-        ::close(fd);
+        return due.size();
     }
-    
-    // 采集电池状态信息
-    void captureBatteryStats() {
-        std::string output = executeCommand("dumpsys battery");
-        try {
-            // 解析电池电量
-            size_t level_pos = output.find("level:");
-            if (level_pos != std::string::npos) {
-                std::string level_str = output.substr(level_pos + 6);
-                system_stats.battery_level = std::stoi(level_str);
+
+    uint64_t wakeups() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return wakeups_;
+    }
+
+    // 最近一小时的唤醒次数
+    size_t wakeupsLastHour() const {
+        auto now = Clock::now();
+        std::lock_guard<std::mutex> lock(mutex_);
+        return std::count_if(recent_wakeups_.begin(), recent_wakeups_.end(),
+            [&](const Clock::time_point& t) { return now - t <= std::chrono::hours(1); });
+    }
+
+    // 平均每次唤醒执行的任务数，衡量合并效果
+    double tasksPerWakeup() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return wakeups_ > 0 ? static_cast<double>(tasks_run_) / wakeups_ : 0.0;
+    }
+
+    nlohmann::json toJson() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto now = Clock::now();
+        nlohmann::json tasks = nlohmann::json::object();
+        for (const auto& task : tasks_) {
+            nlohmann::json entry = { { "runs", task.runs } };
+            if (task.pending) {
+                entry["due_in_s"] = std::chrono::duration_cast<std::chrono::seconds>(task.latest - now).count();
             }
-            
-            // 记录电池温度、充电状态等其他信息可以在这里添加
-        } catch (const std::exception& e) {
-            Logger::log(Logger::Level::WARN, "Failed to parse battery stats");
+            tasks[task.name] = entry;
         }
+        return tasks;
     }
-    
-    // 采集内存使用状况
-    void captureMemoryStats() {
-        std::string output = executeCommand("dumpsys meminfo");
-        try {
-            // 解析总内存和可用内存
-            size_t total_pos = output.find("Total RAM:");
-            size_t free_pos = output.find("Free RAM:");
-            
-            if (total_pos != std::string::npos && free_pos != std::string::npos) {
-                std::string total_str = output.substr(total_pos + 10, output.find("K", total_pos) - total_pos - 10);
-                std::string free_str = output.substr(free_pos + 9, output.find("K", free_pos) - free_pos - 9);
-                
-                long total_ram = std::stol(total_str);
-                long free_ram = std::stol(free_str);
-                
-                // 更新系统统计
-                if (system_stats.samples == 0) {
-                    system_stats.total_memory = total_ram;
-                    system_stats.avg_free_memory = free_ram;
-                } else {
-                    // 使用指数移动平均
-                    system_stats.avg_free_memory = static_cast<long>(
-                        system_stats.avg_free_memory * 0.8 + free_ram * 0.2);
-                }
+
+private:
+    static constexpr auto ERROR_RETRY_DELAY = std::chrono::seconds(10);
+
+    struct Task {
+        std::string name;
+        std::function<void()> run;
+        bool pending{ false };
+        Clock::time_point earliest;
+        Clock::time_point latest;
+        uint64_t runs{ 0 };
+    };
+
+    std::vector<Task> tasks_;
+    mutable std::mutex mutex_;
+    std::deque<Clock::time_point> recent_wakeups_;
+    uint64_t wakeups_{ 0 };
+    uint64_t tasks_run_{ 0 };
+    int epoll_fd_{ -1 };
+    int timer_fd_{ -1 };
+    int event_fd_{ -1 };
+
+    void addFd(int fd) {
+        if (fd == -1) return;
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.fd = fd;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev);
+    }
+
+    std::optional<Clock::time_point> nextDeadline() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::optional<Clock::time_point> deadline;
+        for (const auto& task : tasks_) {
+            if (task.pending && (!deadline || task.latest < *deadline)) {
+                deadline = task.latest;
             }
-        } catch (const std::exception& e) {
-            Logger::log(Logger::Level::WARN, "Failed to parse memory stats");
         }
+        return deadline;
     }
-    
-    // 采集网络活动信息
-    void captureNetworkActivity() {
-        std::string output = executeCommand("cat /proc/net/dev");
-        try {
-            // 提取网络接口统计信息
-            // 这里简化处理，实际应用中可能需要更复杂的解析
-            // 并跟踪不同时间点的数据以计算速率
-            system_stats.samples++;
-        } catch (const std::exception& e) {
-            Logger::log(Logger::Level::WARN, "Failed to parse network stats");
+
+    void waitForDeadline() {
+        auto deadline = nextDeadline();
+        if (deadline && *deadline <= Clock::now()) return;
+        if (epoll_fd_ == -1) {
+            // 无法创建 epoll 时退化为定长休眠
+            std::this_thread::sleep_for(deadline ? *deadline - Clock::now() : Clock::duration(std::chrono::seconds(60)));
+            return;
         }
-    }
-    
-    static std::string executeCommand(const std::string& cmd) {
-        std::array<char, 1024> buffer;
-        std::string result;
-        FILE* pipe = popen(cmd.c_str(), "r");
-        if (!pipe) return "";
-        
-        while (!feof(pipe)) {
-            if (fgets(buffer.data(), buffer.size(), pipe) != nullptr) {
-                result += buffer.data();
+
+        int timeout_ms = -1;
+        if (timer_fd_ != -1) {
+            // 绝对时间定时器：深睡眠期间照常到期，不因系统挂起而漂移
+            itimerspec spec{};
+            if (deadline) {
+                auto ns = deadline->time_since_epoch().count();
+                spec.it_value.tv_sec = ns / 1000000000;
+                spec.it_value.tv_nsec = ns % 1000000000;
             }
+            timerfd_settime(timer_fd_, TFD_TIMER_ABSTIME, &spec, nullptr);
+        } else if (deadline) {
+            auto remaining = std::chrono::ceil<std::chrono::milliseconds>(*deadline - Clock::now()).count();
+            timeout_ms = static_cast<int>(std::clamp<int64_t>(remaining, 0, INT_MAX));
+        }
+
+        epoll_event events[2];
+        int count;
+        do {
+            count = epoll_wait(epoll_fd_, events, 2, timeout_ms);
+        } while (count == -1 && errno == EINTR);
+
+        uint64_t value;
+        for (int i = 0; i < count; ++i) {
+            while (read(events[i].data.fd, &value, sizeof(value)) > 0) {}
         }
-        pclose(pipe);
-        return result;
     }
 };
 
-class IntervalManager {
+// SIGTERM/SIGINT 处理：信号处理函数中只置位标志并写 eventfd 唤醒调度器，
+// 保存历史、回收线程等清理在主循环退出后于主线程完成
+class ShutdownSignal {
 public:
-    IntervalManager(const UserHabits& habits, const UserHabitManager& habit_manager) 
-        : habits_(habits), habit_manager_(habit_manager) {}
+    static void install(int wake_fd) {
+        wake_fd_ = wake_fd;
+        struct sigaction action {};
+        action.sa_handler = onSignal;
+        sigemptyset(&action.sa_mask);
+        action.sa_flags = SA_RESTART;
+        sigaction(SIGTERM, &action, nullptr);
+        sigaction(SIGINT, &action, nullptr);
+    }
 
-    std::chrono::seconds getScreenCheckInterval() const {
-        // 根据学习阶段调整检查间隔
-        auto intensity = habit_manager_.getLearningIntensity();
-        
-        // 根据当前时间段的活动水平调整屏幕检查间隔
-        int current_hour = getCurrentHour();
-        const auto& pattern = habits_.daily_patterns[current_hour];
-        
-        // 基于学习阶段设置基础间隔
-        std::chrono::seconds base_interval;
-        switch (intensity) {
-            case UserHabitManager::LearningIntensity::HIGH:
-                base_interval = SCREEN_CHECK_INTERVAL_LEARNING_HIGH;
-                break;
-            case UserHabitManager::LearningIntensity::MEDIUM:
-                base_interval = SCREEN_CHECK_INTERVAL_LEARNING_MEDIUM;
-                break;
-            case UserHabitManager::LearningIntensity::LOW:
-                base_interval = SCREEN_CHECK_INTERVAL_LEARNING_LOW;
-                break;
-            case UserHabitManager::LearningIntensity::STABLE:
-                // 学习完成后，根据当前时段活动水平动态调整
-                double activity_factor = std::min(1.0, pattern.activity_level);
-                auto dynamic_interval = static_cast<int>(
-                    SCREEN_CHECK_INTERVAL_MAX.count() - 
-                    (SCREEN_CHECK_INTERVAL_MAX - SCREEN_CHECK_INTERVAL_MIN).count() * activity_factor
-                );
-                return std::chrono::seconds(dynamic_interval);
-        }
-        
-        // 在学习阶段，适当考虑时间模式，但以学习强度为主
-        double activity_factor = std::min(0.5, pattern.activity_level / 2);
-        auto adjusted_interval = static_cast<int>(
-            base_interval.count() * (1.0 - activity_factor)
-        );
-        
-        return std::chrono::seconds(adjusted_interval);
+    static bool requested() { return requested_.load(std::memory_order_relaxed); }
+
+private:
+    static inline std::atomic<bool> requested_{ false };
+    static inline int wake_fd_{ -1 };
+
+    static void onSignal(int) {
+        int saved_errno = errno;
+        requested_.store(true, std::memory_order_relaxed);
+        uint64_t value = 1;
+        if (wake_fd_ != -1 && write(wake_fd_, &value, sizeof(value)) < 0) {}
+        errno = saved_errno;
     }
+};
 
-    std::chrono::seconds getProcessCheckInterval(const std::string& package_name) const {
-        auto intensity = habit_manager_.getLearningIntensity();
-        
-        // 学习阶段使用更短的固定间隔
-        if (intensity != UserHabitManager::LearningIntensity::STABLE) {
-            switch (intensity) {
-                case UserHabitManager::LearningIntensity::HIGH:
-                    return PROCESS_CHECK_INTERVAL_LEARNING_HIGH;
-                case UserHabitManager::LearningIntensity::MEDIUM:
-                    return PROCESS_CHECK_INTERVAL_LEARNING_MEDIUM;
-                case UserHabitManager::LearningIntensity::LOW:
-                    return PROCESS_CHECK_INTERVAL_LEARNING_LOW;
-                default:
-                    return PROCESS_CHECK_INTERVAL_DEFAULT;
-            }
-        }
-        
-        // 稳定阶段，基于学习到的用户习惯调整
-        auto it = habits_.app_stats.find(package_name);
-        if (it == habits_.app_stats.end()) {
-            return PROCESS_CHECK_INTERVAL_DEFAULT;
+// 固定大小的探测线程池：阻塞型探测（dumpsys 等）并行执行，
+// 一个周期的耗时取决于最慢的单个探测而不是所有探测之和
+class ProbePool {
+public:
+    explicit ProbePool(size_t threads) {
+        for (size_t i = 0; i < threads; ++i) {
+            threads_.emplace_back(&ProbePool::run, this);
         }
-        
-        // 考虑应用重要性和当前时段
-        double importance = it->second.importance_weight;
-        int current_hour = getCurrentHour();
-        const auto& pattern = habits_.daily_patterns[current_hour];
-        
-        // 检查应用是否在当前时段活跃
-        bool is_active_in_hour = std::find(pattern.active_apps.begin(), 
-                                         pattern.active_apps.end(), 
-                                         package_name) != pattern.active_apps.end();
-        
-        // 活跃应用在其活跃时段检查更频繁
-        double time_factor = is_active_in_hour ? 0.7 : 1.0;
-        
-        auto interval = static_cast<long long>(
-            PROCESS_CHECK_INTERVAL_MAX.count() -
-            (PROCESS_CHECK_INTERVAL_MAX - PROCESS_CHECK_INTERVAL_MIN).count() * 
-            (importance / 100.0) * time_factor
-        );
-        
-        interval = std::max(interval, static_cast<long long>(PROCESS_CHECK_INTERVAL_MIN.count()));
-        return std::chrono::seconds(interval);
     }
 
-    std::chrono::seconds getKillInterval(const std::string& package_name) const {
-        auto intensity = habit_manager_.getLearningIntensity();
-        
-        // 学习阶段使用更短的固定间隔，但不会太短以避免误杀常用应用
-        if (intensity != UserHabitManager::LearningIntensity::STABLE) {
-            // 即使在学习阶段，也要考虑应用重要性
-            auto it = habits_.app_stats.find(package_name);
-            if (it != habits_.app_stats.end() && it->second.importance_weight > 50.0) {
-                // 重要应用即使在学习阶段也应该有更长的存活时间
-                return KILL_INTERVAL_IMPORTANT_APP;
-            }
-            
-            switch (intensity) {
-                case UserHabitManager::LearningIntensity::HIGH:
-                    return KILL_INTERVAL_LEARNING_HIGH;
-                case UserHabitManager::LearningIntensity::MEDIUM:
-                    return KILL_INTERVAL_LEARNING_MEDIUM;
-                case UserHabitManager::LearningIntensity::LOW:
-                    return KILL_INTERVAL_LEARNING_LOW;
-                default:
-                    return KILL_INTERVAL_DEFAULT;
-            }
+    ~ProbePool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
         }
-        
-        // 稳定阶段，基于学习到的用户习惯调整
-        auto it = habits_.app_stats.find(package_name);
-        if (it == habits_.app_stats.end()) {
-            return KILL_INTERVAL_DEFAULT;
+        cv_.notify_all();
+        for (auto& thread : threads_) thread.join();
+    }
+
+    ProbePool(const ProbePool&) = delete;
+    ProbePool& operator=(const ProbePool&) = delete;
+
+    // 探测函数须自带超时且只捕获值，调用方放弃等待后结果会被丢弃
+    template <typename Probe>
+    std::future<std::invoke_result_t<Probe>> submit(Probe probe) {
+        auto task = std::make_shared<std::packaged_task<std::invoke_result_t<Probe>()>>(std::move(probe));
+        auto result = task->get_future();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            queue_.emplace_back([task] { (*task)(); });
         }
-        
-        // 重要应用有更长的后台存活时间
-        double importance = it->second.importance_weight;
-        int current_hour = getCurrentHour();
-        
-        // 检查应用是否在当前时段活跃
-        const auto& pattern = habits_.daily_patterns[current_hour];
-        bool is_active_in_hour = std::find(pattern.active_apps.begin(), 
-                                         pattern.active_apps.end(), 
-                                         package_name) != pattern.active_apps.end();
-        
-        // 在活跃时段，即使在后台也给予更长的存活时间
-        double time_factor = is_active_in_hour ? 1.3 : 1.0;
-        
-        auto interval = static_cast<long long>(
-            KILL_INTERVAL_MIN.count() +
-            (KILL_INTERVAL_MAX - KILL_INTERVAL_MIN).count() * 
-            (importance / 100.0) * time_factor
-        );
-        
-        interval = std::min(interval, static_cast<long long>(KILL_INTERVAL_MAX.count()));
-        return std::chrono::seconds(interval);
+        cv_.notify_one();
+        return result;
     }
 
-    std::chrono::seconds getScreenOffSleepInterval() const {
-        auto intensity = habit_manager_.getLearningIntensity();
-        
-        // 学习阶段使用更短的休眠间隔
-        if (intensity != UserHabitManager::LearningIntensity::STABLE) {
-            switch (intensity) {
-                case UserHabitManager::LearningIntensity::HIGH:
-                    return SCREEN_OFF_SLEEP_INTERVAL_LEARNING_HIGH;
-                case UserHabitManager::LearningIntensity::MEDIUM:
-                    return SCREEN_OFF_SLEEP_INTERVAL_LEARNING_MEDIUM;
-                case UserHabitManager::LearningIntensity::LOW:
-                    return SCREEN_OFF_SLEEP_INTERVAL_LEARNING_LOW;
-                default:
-                    return SCREEN_OFF_SLEEP_INTERVAL;
+    size_t size() const { return threads_.size(); }
+
+    // 默认线程数：探测以等待子进程为主，少量线程即可覆盖并发
+    static size_t defaultSize() {
+        return std::clamp<size_t>(std::thread::hardware_concurrency() / 2, 2, 4);
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<std::function<void()>> queue_;
+    bool stopping_{ false };
+    std::vector<std::thread> threads_;
+
+    void run() {
+        while (true) {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+                if (queue_.empty()) return;
+                job = std::move(queue_.front());
+                queue_.pop_front();
             }
+            job();
         }
-        
-        return SCREEN_OFF_SLEEP_INTERVAL;
     }
+};
 
-private:
-    const UserHabits& habits_;
-    const UserHabitManager& habit_manager_;
-    
-    // 常规阶段间隔
-    static constexpr auto SCREEN_CHECK_INTERVAL_MIN = std::chrono::seconds(30);
-    static constexpr auto SCREEN_CHECK_INTERVAL_MAX = std::chrono::minutes(5);
-    static constexpr auto PROCESS_CHECK_INTERVAL_MIN = std::chrono::seconds(45);
-    static constexpr auto PROCESS_CHECK_INTERVAL_MAX = std::chrono::minutes(3);
-    static constexpr auto PROCESS_CHECK_INTERVAL_DEFAULT = std::chrono::minutes(1);
-    static constexpr auto KILL_INTERVAL_MIN = std::chrono::minutes(5);
-    static constexpr auto KILL_INTERVAL_MAX = std::chrono::minutes(30);
-    static constexpr auto KILL_INTERVAL_DEFAULT = std::chrono::minutes(10);
-    static constexpr auto SCREEN_OFF_SLEEP_INTERVAL = std::chrono::minutes(1);
-    
-    // 学习阶段间隔
-    static constexpr auto SCREEN_CHECK_INTERVAL_LEARNING_HIGH = std::chrono::seconds(15);
-    static constexpr auto SCREEN_CHECK_INTERVAL_LEARNING_MEDIUM = std::chrono::seconds(30);
-    static constexpr auto SCREEN_CHECK_INTERVAL_LEARNING_LOW = std::chrono::seconds(45);
-    
-    static constexpr auto PROCESS_CHECK_INTERVAL_LEARNING_HIGH = std::chrono::seconds(20);
-    static constexpr auto PROCESS_CHECK_INTERVAL_LEARNING_MEDIUM = std::chrono::seconds(30);
-    static constexpr auto PROCESS_CHECK_INTERVAL_LEARNING_LOW = std::chrono::seconds(40);
-    
-    static constexpr auto KILL_INTERVAL_LEARNING_HIGH = std::chrono::minutes(3);
-    static constexpr auto KILL_INTERVAL_LEARNING_MEDIUM = std::chrono::minutes(5);
-    static constexpr auto KILL_INTERVAL_LEARNING_LOW = std::chrono::minutes(7);
-    static constexpr auto KILL_INTERVAL_IMPORTANT_APP = std::chrono::minutes(15);
-    
-    static constexpr auto SCREEN_OFF_SLEEP_INTERVAL_LEARNING_HIGH = std::chrono::seconds(30);
-    static constexpr auto SCREEN_OFF_SLEEP_INTERVAL_LEARNING_MEDIUM = std::chrono::seconds(40);
-    static constexpr auto SCREEN_OFF_SLEEP_INTERVAL_LEARNING_LOW = std::chrono::seconds(50);
+// 守护进程运行选项
+struct DaemonOptions {
+    std::string packages_list_path{ "/data/system/packages.list" };
+    std::string config_path;  // 为空时从命令行参数读取目标（旧协议）
+    size_t max_habit_apps{ UserHabits::DEFAULT_MAX_APPS };
+    std::string module_dir{ DEFAULT_MODULE_DIR };
+    std::string habit_priors_path{ std::string(DEFAULT_MODULE_DIR) + "/module_settings/habit_priors.json" };
+    std::string status_path{ std::string(DEFAULT_MODULE_DIR) + "/logs/status.bin" };
+    std::string history_path{ std::string(DEFAULT_MODULE_DIR) + "/logs/history.bin" };
+    std::string policy{ "balanced" };  // 内置策略名或策略表 JSON 路径
+    std::string trace_path;            // 为空时不记录运行轨迹
+    size_t trace_max_bytes{ TraceRecorder::DEFAULT_MAX_BYTES };
+    std::string fixture_root;          // 非空时从夹具目录回放系统探测，不触碰真实进程
+
+    // 以另一个目录为模块根（压测与测试环境），单独指定的路径在其后覆盖
+    void setModuleDir(const std::string& dir) {
+        module_dir = dir;
+        habit_priors_path = dir + "/module_settings/habit_priors.json";
+        status_path = dir + "/logs/status.bin";
+        history_path = dir + "/logs/history.bin";
+    }
+
+    void setFixtureRoot(const std::string& dir) {
+        fixture_root = dir;
+        packages_list_path = dir + "/data/system/packages.list";
+    }
 };
 
+// 策略类型在编译期确定，内置策略的阈值在热路径上内联
+template <typename Policy>
 class ProcessManager {
 private:
     static constexpr auto INITIAL_SCREEN_CHECK_DELAY = std::chrono::minutes(5); // 减少初始延迟
@@ -1053,10 +5394,36 @@ private:
     std::atomic<bool> running{ true };
     bool is_screen_on{ true };
     std::chrono::steady_clock::time_point last_screen_check;
-    std::chrono::steady_clock::time_point last_additional_data_capture;
     std::map<std::string, std::chrono::steady_clock::time_point> last_process_check_times;
     UserHabitManager habit_manager;
-    IntervalManager interval_manager;
+    IntervalManager<Policy> interval_manager;
+    PackageIndex package_index;
+    ProcessIndex process_index{ package_index };
+    ForegroundDetector foreground_detector{ process_index };
+    std::string focused_package;  // dumpsys 回退方案下的当前焦点应用
+
+    // 屏幕状态与用户交互（监听线程会回调 requestWake，需在调度器之后析构）
+    WakeupScheduler scheduler;
+    WakeupScheduler::TaskId screen_task{};
+    WakeupScheduler::TaskId process_task{};
+    WakeupScheduler::TaskId cleanup_task{};
+    WakeupScheduler::TaskId capture_task{};
+    WakeupScheduler::TaskId habit_task{};
+    WakeupScheduler::TaskId history_task{};
+    WakeupScheduler::TaskId stats_task{};
+    WakeupScheduler::TaskId power_task{};
+    WakeupScheduler::TaskId trace_task{};
+    ProfileSelector profile_selector;
+    static constexpr auto POWER_CHECK_INTERVAL = std::chrono::minutes(5);
+    std::unique_ptr<BacklightScreenProbe> native_screen_probe;
+    DumpsysScreenProbe dumpsys_screen_probe;
+    UserActivityMonitor activity_monitor;
+    std::atomic<bool> screen_change_pending{ false };
+    bool screen_off_cleanup_pending{ false };
+    std::chrono::steady_clock::time_point screen_off_since;
+    static constexpr auto SCREEN_OFF_CLEANUP_IDLE = std::chrono::minutes(1);  // 息屏且无操作多久后清理
+    static constexpr auto SCREEN_OFF_TIMEOUT_REFRESH = std::chrono::minutes(30);
+    std::chrono::steady_clock::time_point last_timeout_read;
     
     // 优先级管理
     struct ProcessPriority {
@@ -1066,6 +5433,19 @@ private:
     };
     std::map<std::string, ProcessPriority> process_priorities;
     
+    // 每个目标的动作效果：杀死的确认延迟、可用内存增量与预估 PSS，回收的实际字节
+    struct ActionOutcomes {
+        Log2Histogram kill_latency_ms;
+        Log2Histogram kill_freed_kb;
+        Log2Histogram kill_pss_kb;
+        Log2Histogram reclaim_kb;
+        int kills_unconfirmed{0};
+
+        double killEffectiveness() const {
+            return kill_pss_kb.sum() > 0 ? static_cast<double>(kill_freed_kb.sum()) / kill_pss_kb.sum() : -1.0;
+        }
+    };
+
     // 统计数据
     struct Statistics {
         int total_processes_managed{0};
@@ -1074,7 +5454,43 @@ private:
         std::chrono::steady_clock::time_point start_time;
         int total_check_cycles{0};
         double avg_check_duration_ms{0.0};
+        double max_probe_duration_ms{0.0};
+        int probe_timeouts{0};
+        long long total_bytes_freed{0};
+        std::map<std::string, long long> freed_bytes_by_package;
+        int total_reclaim_actions{0};
+        long long total_bytes_reclaimed{0};
+        int total_budget_enforcements{0};
+        int total_traffic_enforcements{0};
+        std::map<std::string, int> budget_enforcements_by_package;
+        std::map<std::string, long long> reclaimed_bytes_by_package;
+        std::map<std::string, ActionOutcomes> outcomes_by_package;
     } stats;
+    StatusPage status_page;
+    std::string history_path;
+    bool history_dirty{ false };
+    ProbePool probe_pool{ ProbePool::defaultSize() };
+    TraceRecorder trace;
+    static constexpr auto PROBE_TIMEOUT = std::chrono::seconds(3);      // 单个阻塞探测的上限
+    static constexpr auto PROBE_GRACE = std::chrono::milliseconds(500); // 排队与结果汇总的余量
+    static constexpr auto KILL_CONFIRM_TIMEOUT = std::chrono::seconds(2); // 杀死后等待进程退出的上限
+
+    // 杀死动作的结果由确认线程等待，下个周期汇总
+    using KillOutcome = KillWatcher::Outcome;
+    KillWatcher kill_watcher;
+    struct PendingKill {
+        std::string package_name;
+        long long pss_bytes;
+        std::future<KillOutcome> outcome;
+    };
+    std::vector<PendingKill> pending_kills;
+    static constexpr auto HISTORY_SAVE_INTERVAL = std::chrono::minutes(30);
+    static constexpr auto DATA_CAPTURE_INTERVAL = std::chrono::minutes(15);
+    static constexpr auto HABIT_SAVE_INTERVAL = std::chrono::minutes(15);
+    static constexpr auto SCREEN_OFF_HABIT_SAVE_SLACK = std::chrono::hours(2);
+    static constexpr auto STATS_DUMP_INTERVAL = std::chrono::hours(6);
+    // 有输入监听时屏幕变化会主动回调，轮询仅作兜底
+    static constexpr auto MONITORED_SCREEN_POLL = std::chrono::minutes(30);
 
     struct Target {
         std::string package_name;
@@ -1087,7 +5503,33 @@ private:
         int memory_usage_kb{0};
         bool is_sticky{false};  // 表示应该避免被杀死的应用
         int last_priority{0};
+        bool memory_reclaimed{false};  // 本次后台期间是否已回收过内存
         std::chrono::steady_clock::time_point last_resource_check;
+        TargetPolicy policy;
+        CpuBudget cpu_budget;
+        std::map<pid_t, unsigned long long> last_cpu_ticks;  // 每个进程上次采样的CPU ticks
+        std::chrono::steady_clock::time_point last_cpu_sample;
+        bool cpu_sampled{false};
+        bool budget_enforced{false};  // 本次超预算是否已处理
+        bool is_frozen{false};
+        // 存储与网络速率信号（字节/秒）
+        double io_read_rate{0.0};
+        double io_write_rate{0.0};
+        double net_rx_rate{0.0};
+        double net_tx_rate{0.0};
+        std::map<pid_t, TrafficAccounting::Counters> last_io_counters;
+        TrafficAccounting::Counters last_net_counters;
+        bool net_sampled{false};
+        std::chrono::steady_clock::time_point last_traffic_sample;
+        int io_over_limit_samples{0};
+        int net_over_limit_samples{0};
+        bool traffic_enforced{false};
+        ResourceSeries series;  // 内存/CPU 历史
+        std::future<std::optional<int>> memory_probe;  // 尚未取回的内存探测，超时后留到下个周期
+        // 本检查周期算出的间隔，决策与状态页共用，避免每批任务重算
+        std::chrono::seconds check_interval{0};
+        std::chrono::seconds kill_interval{0};
+        std::chrono::seconds reclaim_interval{0};
 
         Target(std::string pkg, std::vector<std::string> procs)
             : package_name(std::move(pkg)), process_names(std::move(procs)), is_foreground(false),
@@ -1097,68 +5539,206 @@ private:
 
     std::vector<Target> targets;
 
-    static std::string executeCommand(const std::string& cmd) {
-        std::array<char, 256> buffer; // 增加缓冲区大小
-        std::string result;
-        FILE* pipe = popen(cmd.c_str(), "r");
-        if (!pipe) {
-            Logger::log(Logger::Level::ERROR, "Failed to execute command: " + cmd);
-            return "";
+    bool isScreenOn() {
+        // 输入监听线程已维护实时状态，无需再次读取
+        if (activity_monitor.active()) {
+            return activity_monitor.screenOn();
         }
-        while (!feof(pipe)) {
-            if (fgets(buffer.data(), buffer.size(), pipe) != nullptr) {
-                result += buffer.data();
+
+        ScreenStateProbe* probes[] = { native_screen_probe.get(), &dumpsys_screen_probe };
+        for (ScreenStateProbe* probe : probes) {
+            if (!probe) continue;
+            if (auto state = probe->readScreenOn()) {
+                return *state;
             }
         }
-        pclose(pipe);
-        return result;
+        return true; // 默认屏幕开启，避免误杀进程
     }
 
-    bool isScreenOn() {
-        std::string output = executeCommand("dumpsys display");
-        
-        // 查找包含 "mScreenState=" 的行
-        const std::string target = "mScreenState=";
-        size_t pos = output.find(target);
-        if (pos == std::string::npos) {
-            Logger::log(Logger::Level::WARN, "Failed to find screen state in dumpsys display output");
-            return true; // 默认屏幕开启，避免误杀进程
+    void publishStatus() {
+        if (!status_page.active()) return;
+        auto now = std::chrono::steady_clock::now();
+        const auto& habits = habit_manager.getHabits();
+        auto writer_stats = habit_manager.writerStats();
+
+        status_page.beginUpdate();
+        auto* header = status_page.header();
+        header->learning_hours = habits.learning_hours;
+        header->learning_intensity = static_cast<uint8_t>(habit_manager.getLearningIntensity());
+        header->screen_on = is_screen_on ? 1 : 0;
+        header->profile = static_cast<uint8_t>(interval_manager.profile());
+        header->policy = static_cast<uint8_t>(Policy::KIND);
+        header->start_time = std::chrono::system_clock::to_time_t(
+            std::chrono::system_clock::now() - std::chrono::duration_cast<std::chrono::system_clock::duration>(now - start_time));
+        header->update_time = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        header->total_check_cycles = stats.total_check_cycles;
+        header->total_wakeups = scheduler.wakeups();
+        header->wakeups_last_hour = scheduler.wakeupsLastHour();
+        header->total_processes_killed = stats.total_processes_killed;
+        header->total_bytes_freed = stats.total_bytes_freed;
+        header->total_bytes_reclaimed = stats.total_bytes_reclaimed;
+        header->total_budget_enforcements = stats.total_budget_enforcements;
+        header->total_traffic_enforcements = stats.total_traffic_enforcements;
+        header->commands_spawned = CommandRunner::spawnCount();
+        header->command_timeouts = CommandRunner::timeoutCount();
+        header->habit_saves = writer_stats.saves;
+        header->avg_check_duration_ms = stats.avg_check_duration_ms;
+        header->habit_save_avg_ms = writer_stats.avg_ms;
+
+        size_t count = std::min<size_t>(targets.size(), StatusPage::MAX_TARGETS);
+        for (size_t i = 0; i < count; ++i) {
+            const auto& target = targets[i];
+            auto& status = *status_page.target(i);
+            StatusPage::setName(status, target.package_name);
+            status.foreground = target.is_foreground;
+            status.frozen = target.is_frozen;
+            status.sticky = target.is_sticky;
+            status.budget_enforced = target.budget_enforced;
+            status.traffic_enforced = target.traffic_enforced;
+            status.memory_reclaimed = target.memory_reclaimed;
+            auto priority = process_priorities.find(target.package_name);
+            status.oom_adj_score = priority != process_priorities.end() ? priority->second.oom_adj_score : 0;
+            status.nice_value = priority != process_priorities.end() ? priority->second.nice_value : 0;
+            status.cpu_usage_percent = target.cpu_usage_percent;
+            status.memory_usage_kb = target.memory_usage_kb;
+            auto kills = stats.killed_count_by_package.find(target.package_name);
+            status.kill_count = kills != stats.killed_count_by_package.end() ? kills->second : 0;
+            auto freed = stats.freed_bytes_by_package.find(target.package_name);
+            status.freed_bytes = freed != stats.freed_bytes_by_package.end() ? freed->second : 0;
+            auto reclaimed = stats.reclaimed_bytes_by_package.find(target.package_name);
+            status.reclaimed_bytes = reclaimed != stats.reclaimed_bytes_by_package.end() ? reclaimed->second : 0;
+            static const ActionOutcomes NO_OUTCOMES;
+            auto outcomes_it = stats.outcomes_by_package.find(target.package_name);
+            const auto& outcomes = outcomes_it != stats.outcomes_by_package.end() ? outcomes_it->second : NO_OUTCOMES;
+            status.kills_measured = outcomes.kill_latency_ms.count();
+            status.kills_unconfirmed = outcomes.kills_unconfirmed;
+            status.kill_latency_p50_ms = outcomes.kill_latency_ms.quantile(0.5);
+            status.kill_latency_p95_ms = outcomes.kill_latency_ms.quantile(0.95);
+            status.kill_freed_p50_kb = outcomes.kill_freed_kb.quantile(0.5);
+            status.kill_pss_p50_kb = outcomes.kill_pss_kb.quantile(0.5);
+            status.reclaims_measured = outcomes.reclaim_kb.count();
+            status.reclaim_p50_kb = outcomes.reclaim_kb.quantile(0.5);
+            status.kill_effectiveness = outcomes.killEffectiveness();
+            status.check_interval_s = target.check_interval.count();
+            status.kill_interval_s = target.kill_interval.count();
+            status.reclaim_interval_s = target.reclaim_interval.count();
+            status.background_seconds = target.is_foreground ? -1 :
+                std::chrono::duration_cast<std::chrono::seconds>(now - target.last_background_time).count();
+            status.io_read_rate = target.io_read_rate;
+            status.io_write_rate = target.io_write_rate;
+            status.net_rx_rate = target.net_rx_rate;
+            status.net_tx_rate = target.net_tx_rate;
         }
-        
-        // 获取状态值
-        pos += target.length();
-        size_t end = output.find('\n', pos);
-        if (end == std::string::npos) {
-            end = output.length();
+        header->target_count = count;
+        status_page.endUpdate();
+    }
+
+    void saveResourceHistory() {
+        std::vector<std::pair<std::string, const ResourceSeries*>> series;
+        for (const auto& target : targets) {
+            series.emplace_back(target.package_name, &target.series);
         }
-        
-        // 提取并比较状态值
-        std::string state = output.substr(pos, end - pos);
-        bool screen_on = state.find("ON") != std::string::npos;
-        Logger::log(Logger::Level::INFO, "Screen state: " + state + " (" + (screen_on ? "on" : "off") + ")");
-        return screen_on;
+        ResourceHistoryFile::save(history_path, series);
+        history_dirty = false;
+    }
+
+    void requestWake() {
+        scheduler.runSoon(screen_task);
+    }
+
+    // 用户无操作的时长；没有输入监听时退化为息屏以来的时长
+    std::chrono::steady_clock::duration userIdleTime() const {
+        if (activity_monitor.active()) {
+            return activity_monitor.idleTime();
+        }
+        return is_screen_on ? std::chrono::steady_clock::duration::zero() :
+            std::chrono::steady_clock::now() - screen_off_since;
+    }
+
+    // 用户可能随时修改息屏超时，亮屏时按间隔重新读取
+    void refreshScreenOffTimeout() {
+        auto now = std::chrono::steady_clock::now();
+        if (last_timeout_read.time_since_epoch().count() != 0 && now - last_timeout_read < SCREEN_OFF_TIMEOUT_REFRESH) return;
+        last_timeout_read = now;
+
+        std::string timeout = SystemProbe::current().run({ "settings", "get", "system", "screen_off_timeout" });
+        long timeout_ms = strtol(timeout.c_str(), nullptr, 10);
+        if (timeout_ms > 0) {
+            activity_monitor.setScreenOffTimeout(std::chrono::milliseconds(timeout_ms));
+        }
+    }
+
+    void startActivityMonitor() {
+        native_screen_probe = BacklightScreenProbe::create();
+        if (!native_screen_probe) {
+            Logger::log(Logger::Level::INFO, "No backlight node found, using dumpsys display for screen state");
+            return;
+        }
+        Logger::log(Logger::Level::INFO, "Using backlight node for screen state: " +
+            native_screen_probe->brightnessPath());
+
+        refreshScreenOffTimeout();
+        activity_monitor.start(native_screen_probe.get(), [this](bool screen_on) {
+            Logger::log(Logger::Level::INFO, std::format("Screen state changed: {}", screen_on ? "on" : "off"));
+            screen_change_pending = true;
+            requestWake();
+        });
     }
 
-    bool shouldCheckProcesses(const std::string& package_name) {
+    bool shouldCheckProcesses(const Target& target) {
         auto now = std::chrono::steady_clock::now();
-        auto it = last_process_check_times.find(package_name);
+        auto it = last_process_check_times.find(target.package_name);
         if (it == last_process_check_times.end()) {
-            last_process_check_times[package_name] = now;
+            last_process_check_times[target.package_name] = now;
             return true;
         }
-        if (now - it->second >= interval_manager.getProcessCheckInterval(package_name)) {
+        // 允许提前四分之一周期，使间隔相近的目标落在同一次唤醒中
+        auto interval = target.check_interval;
+        if (now - it->second >= interval - interval / 4) {
             it->second = now;
             return true;
         }
         return false;
     }
 
-    bool isProcessForeground(const std::string& package_name) noexcept {
-        std::string output = executeCommand("dumpsys window");
-        
+    // 每个检查周期刷新一次前台应用集合，之后的查询只是集合查找
+    // 只读 top-app 成员，不扫描 /proc：索引中没有的新进程由 cmdlineOf 直接读取
+    void refreshForegroundState() {
+        if (foreground_detector.available()) {
+            foreground_detector.refresh();
+            return;
+        }
+
+        // 回退方案：每周期只执行一次 dumpsys window
+        focused_package = parseFocusedPackage(SystemProbe::current().run({ "dumpsys", "window" }, [](std::string_view line) {
+            return (line.find("mCurrentFocus") != std::string_view::npos ||
+                    line.find("mFocusedWindow") != std::string_view::npos) &&
+                   line.find("Window{") != std::string_view::npos;
+        }));
+    }
+
+    // 将本周期的前台集合喂给下一应用预测模型
+    void observeForegroundTransitions() {
+        if (foreground_detector.available()) {
+            habit_manager.observeForeground(foreground_detector.foregroundPackages());
+            trace.foreground(foreground_detector.foregroundPackages());
+        } else if (!focused_package.empty()) {
+            habit_manager.observeForeground({ focused_package });
+            trace.foreground({ focused_package });
+        }
+    }
+
+    bool isProcessForeground(const std::string& package_name) const noexcept {
+        if (foreground_detector.available()) {
+            return foreground_detector.isForeground(package_name);
+        }
+        return !focused_package.empty() && focused_package == package_name;
+    }
+
+    static std::string parseFocusedPackage(const std::string& output) {
         // 优化：只检查关键部分
         const std::string focus_markers[] = {"mCurrentFocus", "mFocusedWindow"};
-        std::string current_pkg;
         
         for (const auto& marker : focus_markers) {
             size_t pos = output.find(marker);
@@ -1187,46 +5767,168 @@ private:
                             size_t pkg_start = window_content.rfind(' ', slash_pos);
                             if (pkg_start != std::string::npos) {
                                 pkg_start++; // 跳过空格
-                                current_pkg = window_content.substr(pkg_start, slash_pos - pkg_start);
-                                
-                                // 如果找到匹配的包名，立即返回
-                                if (current_pkg == package_name) {
-                                    return true;
-                                }
+                                return window_content.substr(pkg_start, slash_pos - pkg_start);
                             }
                         }
                     }
                 }
             }
         }
-        
-        return false;
+        
+        return "";
+    }
+
+    // 目标所有进程的 PID：按 UID 归属到该包，覆盖多用户副本和隔离子进程
+    std::vector<pid_t> getTargetPids(const Target& target) {
+        package_index.checkForUpdates();
+        process_index.ensureFresh();
+
+        std::vector<pid_t> pids;
+        for (const auto& process_name : target.process_names) {
+            for (pid_t pid : process_index.pidsOf(target.package_name, process_name)) {
+                if (std::find(pids.begin(), pids.end(), pid) == pids.end()) {
+                    pids.push_back(pid);
+                }
+            }
+        }
+        return pids;
+    }
+
+    // 回收后台目标的内存而不杀死进程，保留应用状态
+    void reclaimTargetMemory(Target& target) {
+        long long total_reclaimed = 0;
+        int reclaimed_processes = 0;
+
+        for (pid_t pid : collectTreePids(target)) {
+            long long reclaimed = MemoryReclaimer::reclaim(pid);
+            if (reclaimed >= 0) {
+                total_reclaimed += reclaimed;
+                reclaimed_processes++;
+            }
+        }
+
+        target.memory_reclaimed = true;
+        if (reclaimed_processes == 0) return;
+
+        stats.total_reclaim_actions++;
+        stats.total_bytes_reclaimed += total_reclaimed;
+        stats.reclaimed_bytes_by_package[target.package_name] += total_reclaimed;
+        stats.outcomes_by_package[target.package_name].reclaim_kb.add(total_reclaimed / 1024);
+        Logger::log(Logger::Level::INFO, std::format("Reclaimed {}KB from {} processes of {}",
+            total_reclaimed / 1024, reclaimed_processes, target.package_name));
+    }
+
+    // 目标的进程树：配置的进程、其子孙进程，以及进程名属于该包的隔离进程。
+    // WebView 渲染进程由 webview_zygote 派生，进程名属于 WebView 提供方，不归入宿主应用
+    std::vector<pid_t> collectTreePids(const Target& target) {
+        std::vector<pid_t> roots = getTargetPids(target);
+        if (roots.empty()) return roots;
+
+        std::set<pid_t> members(roots.begin(), roots.end());
+        std::vector<pid_t> candidates = process_index.pidsOfPackage(target.package_name);
+
+        // 同 UID 进程中沿 ppid 向上能到达根进程的为子孙进程
+        std::map<pid_t, pid_t> parents;
+        for (pid_t pid : candidates) {
+            ProcStat proc_stat;
+            if (readProcStat(pid, proc_stat)) {
+                parents[pid] = proc_stat.ppid;
+            }
+        }
+        for (pid_t pid : candidates) {
+            if (members.count(pid)) continue;
+
+            const auto* owner = process_index.ownerOf(pid);
+            bool include = owner && owner->isolated;
+            for (pid_t ancestor = pid; !include && parents.count(ancestor);) {
+                ancestor = parents[ancestor];
+                include = members.count(ancestor) > 0;
+            }
+            if (include) {
+                members.insert(pid);
+            }
+        }
+
+        return std::vector<pid_t>(members.begin(), members.end());
     }
 
-    void killProcess(const std::string& process_name, const std::string& package_name) {
-        // 获取进程PID
-        std::string pid_cmd = "pidof " + process_name;
-        std::string pid_output = executeCommand(pid_cmd);
-        
-        if (!pid_output.empty()) {
-            try {
-                int pid = std::stoi(pid_output);
-                // 使用kill命令杀死指定进程
-                std::string kill_cmd = "kill -9 " + std::to_string(pid);
-                system(kill_cmd.c_str());
-                
-                // 记录操作
-                Logger::log(Logger::Level::INFO, std::format("Killed process: {} (PID: {}) for package: {}", 
-                    process_name, pid, package_name));
-                stats.total_processes_killed++;
-                stats.killed_count_by_package[package_name]++;
-                return;
-                } catch (const std::exception& e) {
-                Logger::log(Logger::Level::INFO, std::format("killkiss.....", process_name));
+    // 进程树的 PSS 总和，读取 smaps_rollup 开销较大，仅在杀死前计算
+    static long long sumPssBytes(const std::vector<pid_t>& pids) {
+        long long total = 0;
+        for (pid_t pid : pids) {
+            long long pss = MemoryReclaimer::readPssBytes(pid);
+            if (pss > 0) total += pss;
+        }
+        return total;
+    }
+
+    // 对目标的整个进程树执行抑制动作，返回受影响的进程数
+    int applySuppressAction(Target& target, SuppressAction action) {
+        auto started = std::chrono::steady_clock::now();
+        std::vector<pid_t> pids = collectTreePids(target);
+        if (pids.empty()) return 0;
+
+        int affected = 0;
+        long long pss_bytes = 0;
+        if (action == SuppressAction::KILL) {
+            pss_bytes = sumPssBytes(pids);
+            long long available_before = readMemAvailableBytes();
+            ExitWatch watch(pids);
+            affected = ProcessActuator::killAll(pids);
+            if (affected > 0) {
+                stats.total_processes_killed += affected;
+                stats.killed_count_by_package[target.package_name] += affected;
+                stats.total_bytes_freed += pss_bytes;
+                stats.freed_bytes_by_package[target.package_name] += pss_bytes;
+                watchKill(target.package_name, pss_bytes, std::move(watch), started, available_before);
+            }
+            target.is_frozen = false;
+        } else {
+            for (pid_t pid : pids) {
+                bool ok = action == SuppressAction::FREEZE ? ProcessActuator::freeze(pid) : ProcessActuator::throttle(pid);
+                if (ok) affected++;
+            }
+            target.is_frozen = target.is_frozen || action == SuppressAction::FREEZE;
+        }
+
+        std::string message = std::format("{} {}: {}/{} processes", suppressActionName(action),
+            target.package_name, affected, pids.size());
+        if (action == SuppressAction::KILL) message += std::format(", {}KB", pss_bytes / 1024);
+        Logger::log(Logger::Level::INFO, message);
+        return affected;
+    }
+
+    void killProcess(Target& target) {
+        applySuppressAction(target, SuppressAction::KILL);
+    }
+
+    // 由确认线程等待被杀进程全部退出，随后读取可用内存，不阻塞执行阶段也不占用探测线程
+    void watchKill(const std::string& package_name, long long pss_bytes, ExitWatch watch,
+                   std::chrono::steady_clock::time_point started, long long available_before) {
+        auto outcome = kill_watcher.watch(std::move(watch), started, available_before, KILL_CONFIRM_TIMEOUT);
+        pending_kills.push_back({ package_name, pss_bytes, std::move(outcome) });
+    }
+
+    // 汇总已完成的杀死结果；可用内存是全局值，同时杀死多个目标时增量会相互重叠
+    void collectKillOutcomes() {
+        for (auto it = pending_kills.begin(); it != pending_kills.end();) {
+            if (it->outcome.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+                ++it;
+                continue;
+            }
+            KillOutcome result = it->outcome.get();
+            auto& outcomes = stats.outcomes_by_package[it->package_name];
+            if (result.confirmed) {
+                outcomes.kill_latency_ms.add(std::llround(result.latency_ms));
+                outcomes.kill_freed_kb.add(std::max(0LL, result.available_delta) / 1024);
+                outcomes.kill_pss_kb.add(it->pss_bytes / 1024);
+            } else {
+                outcomes.kills_unconfirmed++;
+                Logger::log(Logger::Level::WARN, std::format("Processes of {} still alive {}ms after kill",
+                    it->package_name, std::llround(result.latency_ms)));
             }
+            it = pending_kills.erase(it);
         }
-        stats.total_processes_killed++;
-        stats.killed_count_by_package[package_name]++;
     }
     
     void adjustProcessPriority(Target& target) {
@@ -1234,15 +5936,16 @@ private:
             // 后台进程，根据重要性设置优先级
             auto it = habit_manager.getHabits().app_stats.find(target.package_name);
             if (it != habit_manager.getHabits().app_stats.end()) {
-                double importance = it->second.importance_weight;
+                double importance = it->second.importanceWeight();
                 
+                const auto& table = interval_manager.table();
                 // 设置OOM调整分数 - 对重要应用更友好
-                int oom_adj = static_cast<int>(900 - importance * 8);  // 范围约为100-900
-                oom_adj = std::max(100, std::min(900, oom_adj));
+                int oom_adj = static_cast<int>(table.oom_adj_max - importance / 100.0 * (table.oom_adj_max - table.oom_adj_min));
+                oom_adj = std::clamp(oom_adj, table.oom_adj_min, table.oom_adj_max);
                 
                 // 设置nice值 - 重要应用获得更好的CPU优先级
-                int nice_value = static_cast<int>(10 + (100 - importance) / 10);  // 范围约为10-20
-                nice_value = std::max(10, std::min(19, nice_value));
+                int nice_value = static_cast<int>(table.nice_min + (100 - importance) / 100.0 * (table.nice_max + 1 - table.nice_min));
+                nice_value = std::clamp(nice_value, table.nice_min, table.nice_max);
                 
                 // 记录优先级值
                 ProcessPriority priority;
@@ -1251,28 +5954,14 @@ private:
                 process_priorities[target.package_name] = priority;
                 
                 // 应用优先级设置
-                std::string pid_cmd = "pidof " + target.process_names[0];
-                std::string pid_output = executeCommand(pid_cmd);
-                if (!pid_output.empty()) {
-                    try {
-                        int pid = std::stoi(pid_output);
-                        
-                        // 设置OOM调整值
-                        std::string oom_cmd = "echo " + std::to_string(oom_adj) + 
-                                            " > /proc/" + std::to_string(pid) + "/oom_score_adj";
-                        system(oom_cmd.c_str());
-                        
-                        // 设置nice值
-                        std::string nice_cmd = "renice -n " + std::to_string(nice_value) + 
-                                            " -p " + std::to_string(pid);
-                        system(nice_cmd.c_str());
-                        
-                        Logger::log(Logger::Level::INFO, 
-                            std::format("Adjusted priority for {}: OOM={}, nice={}", 
-                                      target.package_name, oom_adj, nice_value));
-                    } catch (const std::exception& e) {
-                        // PID解析失败
-                    }
+                std::vector<pid_t> pids = getTargetPids(target);
+                for (pid_t pid : pids) {
+                    ProcessActuator::setPriority(pid, oom_adj, nice_value);
+                }
+                if (!pids.empty()) {
+                    Logger::log(Logger::Level::INFO, 
+                        std::format("Adjusted priority for {}: OOM={}, nice={}", 
+                                  target.package_name, oom_adj, nice_value));
                 }
             }
         } else {
@@ -1282,84 +5971,217 @@ private:
             priority.nice_value = 0;     // 最高的CPU优先级
             process_priorities[target.package_name] = priority;
             
-            // 查找PID并应用优先级
-            std::string pid_cmd = "pidof " + target.process_names[0];
-            std::string pid_output = executeCommand(pid_cmd);
-            if (!pid_output.empty()) {
-                try {
-                    int pid = std::stoi(pid_output);
-                    
-                    // 设置最佳优先级
-                    std::string oom_cmd = "echo 0 > /proc/" + std::to_string(pid) + "/oom_score_adj";
-                    system(oom_cmd.c_str());
-                    
-                    std::string nice_cmd = "renice -n 0 -p " + std::to_string(pid);
-                    system(nice_cmd.c_str());
-                    
-                    Logger::log(Logger::Level::INFO, 
-                        std::format("Set high priority for foreground app {}", target.package_name));
-                } catch (const std::exception& e) {
-                    // PID解析失败
-                }
+            // 查找PID并设置最佳优先级
+            std::vector<pid_t> pids = getTargetPids(target);
+            for (pid_t pid : pids) {
+                ProcessActuator::setPriority(pid, 0, 0);
+            }
+            if (!pids.empty()) {
+                Logger::log(Logger::Level::INFO, 
+                    std::format("Set high priority for foreground app {}", target.package_name));
             }
         }
     }
     
+    bool resourceSampleDue(const Target& target, std::chrono::steady_clock::time_point now) const {
+        return now - target.last_resource_check >= std::chrono::seconds(30);  // 避免频繁检查
+    }
+
+    // 在探测线程中执行：只使用传入的包名，不访问共享状态
+    static std::optional<int> probeMemoryKb(const std::string& package_name) {
+        std::string mem_output;
+        SystemProbe::current().run({ "dumpsys", "meminfo", package_name }, [&mem_output](std::string_view line) {
+            size_t start = line.find_first_not_of(' ');
+            if (start != std::string_view::npos && line.substr(start).starts_with("TOTAL")) {
+                mem_output = line.substr(start);
+                return true;
+            }
+            return false;
+        }, PROBE_TIMEOUT);
+
+        // 从输出中提取内存使用值（KB）
+        size_t pos = mem_output.find_first_of("0123456789");
+        if (pos == std::string::npos) return std::nullopt;
+        try {
+            return std::stoi(mem_output.substr(pos));
+        } catch (const std::exception& e) {
+            return std::nullopt;  // 解析失败
+        }
+    }
+
+    // 内存由探测线程取得，CPU 与流量直接读 /proc（开销很小，且会修改目标状态）
     void collectProcessResourceUsage(Target& target) {
         auto now = std::chrono::steady_clock::now();
-        if (now - target.last_resource_check < std::chrono::seconds(30)) {
-            return;  // 避免频繁检查
-        }
         
-        // 收集内存使用情况
-        std::string mem_cmd = "dumpsys meminfo " + target.package_name + " | grep TOTAL";
-        std::string mem_output = executeCommand(mem_cmd);
+        // 收集CPU使用情况
+        sampleCpuTime(target, now);
+
+        // 收集存储 I/O 与网络流量
+        sampleTraffic(target, now);
+
+        target.series.add(static_cast<uint32_t>(time(nullptr)), static_cast<uint32_t>(std::max(0, target.memory_usage_kb)),
+            static_cast<uint16_t>(std::clamp(target.cpu_usage_percent, 0, 0xFFFF)));
+        history_dirty = true;
+        trace.sample(target.package_name, target.memory_usage_kb, target.cpu_usage_percent,
+            target.io_read_rate, target.io_write_rate, target.net_rx_rate, target.net_tx_rate);
         
-        if (!mem_output.empty()) {
-            try {
-                // 从输出中提取内存使用值（KB）
-                size_t pos = mem_output.find_first_of("0123456789");
-                if (pos != std::string::npos) {
-                    std::string mem_str = mem_output.substr(pos);
-                    target.memory_usage_kb = std::stoi(mem_str);
+        target.last_resource_check = now;
+    }
+
+    // 根据 /proc/<pid>/stat 的CPU时间差计算占用率，并在后台时扣减CPU预算
+    void sampleCpuTime(Target& target, std::chrono::steady_clock::time_point now) {
+        static const long ticks_per_second = sysconf(_SC_CLK_TCK);
+
+        std::map<pid_t, unsigned long long> current_ticks;
+        unsigned long long delta_ticks = 0;
+        for (pid_t pid : collectTreePids(target)) {
+            ProcStat proc_stat;
+            if (!readProcStat(pid, proc_stat)) continue;
+
+            unsigned long long ticks = proc_stat.utime + proc_stat.stime;
+            current_ticks[pid] = ticks;
+            // 新出现的进程在上次采样之后启动，其全部CPU时间都计入本次
+            auto it = target.last_cpu_ticks.find(pid);
+            delta_ticks += it != target.last_cpu_ticks.end() && ticks >= it->second ?
+                ticks - it->second : ticks;
+        }
+
+        if (target.cpu_sampled) {
+            double cpu_seconds = static_cast<double>(delta_ticks) / ticks_per_second;
+            double elapsed = std::chrono::duration<double>(now - target.last_cpu_sample).count();
+            if (elapsed > 0) {
+                target.cpu_usage_percent = static_cast<int>(cpu_seconds * 100.0 / elapsed);
+            }
+            if (!target.is_foreground) {
+                target.cpu_budget.consume(cpu_seconds, now);
+                if (!target.cpu_budget.exhausted()) {
+                    target.budget_enforced = false;  // 预算恢复后允许再次处理
                 }
-            } catch (const std::exception& e) {
-                // 解析失败
             }
         }
-        
-        // 收集CPU使用情况
-        std::string cpu_cmd = "dumpsys cpuinfo | grep " + target.package_name;
-        std::string cpu_output = executeCommand(cpu_cmd);
-        
-        if (!cpu_output.empty()) {
-            try {
-                // 从输出中提取CPU使用百分比
-                size_t percent_pos = cpu_output.find('%');
-                if (percent_pos != std::string::npos && percent_pos > 0) {
-                    size_t start_pos = cpu_output.rfind(' ', percent_pos - 1);
-                    if (start_pos != std::string::npos) {
-                        std::string cpu_str = cpu_output.substr(start_pos + 1, percent_pos - start_pos - 1);
-                        target.cpu_usage_percent = static_cast<int>(std::stof(cpu_str));
-                    }
-                }
-            } catch (const std::exception& e) {
-                // 解析失败
+
+        target.last_cpu_ticks = std::move(current_ticks);
+        target.last_cpu_sample = now;
+        target.cpu_sampled = true;
+    }
+
+    // 计算目标的存储读写速率与网络收发速率
+    void sampleTraffic(Target& target, std::chrono::steady_clock::time_point now) {
+        double elapsed = std::chrono::duration<double>(now - target.last_traffic_sample).count();
+        bool has_baseline = target.last_traffic_sample.time_since_epoch().count() != 0 && elapsed > 0;
+
+        std::map<pid_t, TrafficAccounting::Counters> current_io;
+        TrafficAccounting::Counters io_delta;
+        TrafficAccounting::Counters net_total;
+        std::set<long> seen_uids;
+        bool net_available = false;
+
+        for (pid_t pid : collectTreePids(target)) {
+            TrafficAccounting::Counters io;
+            if (TrafficAccounting::readIoCounters(pid, io)) {
+                current_io[pid] = io;
+                // 与 CPU 采样一致：新出现的进程在上次采样之后启动，其全部读写都计入本次
+                auto it = target.last_io_counters.find(pid);
+                TrafficAccounting::Counters last = it != target.last_io_counters.end() ? it->second : TrafficAccounting::Counters{};
+                io_delta.read_bytes += io.read_bytes - std::min(io.read_bytes, last.read_bytes);
+                io_delta.write_bytes += io.write_bytes - std::min(io.write_bytes, last.write_bytes);
+            }
+
+            // 网络按 UID 统计，同一应用的多个进程只计一次
+            TrafficAccounting::Counters net;
+            long uid = readProcUid(pid);
+            if (uid >= 0 && seen_uids.insert(uid).second &&
+                TrafficAccounting::readUidNetCounters(uid, net)) {
+                net_total.read_bytes += net.read_bytes;
+                net_total.write_bytes += net.write_bytes;
+                net_available = true;
+            } else if (TrafficAccounting::readPrivateNetnsCounters(pid, net)) {
+                net_total.read_bytes += net.read_bytes;
+                net_total.write_bytes += net.write_bytes;
+                net_available = true;
             }
         }
-        
-        target.last_resource_check = now;
+
+        if (has_baseline) {
+            target.io_read_rate = io_delta.read_bytes / elapsed;
+            target.io_write_rate = io_delta.write_bytes / elapsed;
+            if (net_available && target.net_sampled &&
+                net_total.read_bytes >= target.last_net_counters.read_bytes &&
+                net_total.write_bytes >= target.last_net_counters.write_bytes) {
+                target.net_rx_rate = (net_total.read_bytes - target.last_net_counters.read_bytes) / elapsed;
+                target.net_tx_rate = (net_total.write_bytes - target.last_net_counters.write_bytes) / elapsed;
+            } else {
+                target.net_rx_rate = 0.0;
+                target.net_tx_rate = 0.0;
+            }
+        }
+
+        target.last_io_counters = std::move(current_io);
+        target.last_net_counters = net_total;
+        target.net_sampled = net_available;
+        target.last_traffic_sample = now;
+
+        // 连续两次采样超限才视为持续的后台同步风暴
+        double io_kbps = (target.io_read_rate + target.io_write_rate) / 1024.0;
+        double net_kbps = (target.net_rx_rate + target.net_tx_rate) / 1024.0;
+        double limit_scale = interval_manager.throttleScale();
+        bool io_over = target.policy.io_limit_kbps > 0 && io_kbps > target.policy.io_limit_kbps * limit_scale;
+        bool net_over = target.policy.net_limit_kbps > 0 && net_kbps > target.policy.net_limit_kbps * limit_scale;
+        target.io_over_limit_samples = io_over && !target.is_foreground ? target.io_over_limit_samples + 1 : 0;
+        target.net_over_limit_samples = net_over && !target.is_foreground ? target.net_over_limit_samples + 1 : 0;
+        if (!io_over && !net_over) {
+            target.traffic_enforced = false;
+        }
+    }
+
+    // 后台存储或网络速率持续超限时执行对应动作
+    void enforceTrafficLimits(Target& target) {
+        bool io_triggered = target.io_over_limit_samples >= 2;
+        SuppressAction action = io_triggered ? target.policy.io_limit_action : target.policy.net_limit_action;
+        Logger::log(Logger::Level::INFO, std::format(
+            "{} limit exceeded for {} (io: {:.1f}KB/s, net: {:.1f}KB/s), action: {}",
+            io_triggered ? "I/O" : "Network", target.package_name,
+            (target.io_read_rate + target.io_write_rate) / 1024.0,
+            (target.net_rx_rate + target.net_tx_rate) / 1024.0,
+            suppressActionName(action)));
+
+        applySuppressAction(target, action);
+        target.traffic_enforced = true;
+        stats.total_traffic_enforcements++;
+    }
+
+    // 后台CPU预算耗尽时按策略限制、冻结或杀死目标进程
+    void enforceCpuBudget(Target& target) {
+        SuppressAction action = target.policy.cpu_budget_action;
+        Logger::log(Logger::Level::INFO, std::format(
+            "CPU budget exhausted for {} ({:.1f}s per {}s), action: {}",
+            target.package_name, target.policy.cpu_budget_seconds,
+            target.policy.cpu_budget_window.count(), suppressActionName(action)));
+
+        applySuppressAction(target, action);
+        target.budget_enforced = true;
+        stats.total_budget_enforcements++;
+        stats.budget_enforcements_by_package[target.package_name]++;
+    }
+
+    void thawTarget(Target& target) {
+        for (pid_t pid : collectTreePids(target)) {
+            ProcessActuator::thaw(pid);
+        }
+        target.is_frozen = false;
+        Logger::log(Logger::Level::INFO, "Thawed " + target.package_name);
     }
 
     void checkScreenState() {
         auto now = std::chrono::steady_clock::now();
-        if (now - start_time < INITIAL_SCREEN_CHECK_DELAY ||
-            now - last_screen_check < interval_manager.getScreenCheckInterval()) {
+        bool state_changed = screen_change_pending.exchange(false);
+        if (now - start_time < INITIAL_SCREEN_CHECK_DELAY && !state_changed) {
             return;
         }
 
         bool previous_screen_state = is_screen_on;
         is_screen_on = isScreenOn();
+        trace.screen(is_screen_on);
         
         // 计算自上次检查以来的时间
         int duration = std::chrono::duration_cast<std::chrono::seconds>(now - last_screen_check).count();
@@ -1368,133 +6190,150 @@ private:
         // 更新屏幕统计信息
         habit_manager.updateScreenStats(previous_screen_state, duration);
 
-        // 屏幕关闭时处理
+        // 屏幕关闭时处理：等待用户真正空闲后再清理，避免短暂息屏误杀
         if (!is_screen_on && previous_screen_state) {
             Logger::log(Logger::Level::INFO, "Screen turned off, entering deep sleep mode");
-            handleScreenOff();
-        }
-        
-        // 收集额外系统数据
-        if (now - last_additional_data_capture > std::chrono::minutes(15)) {
-            habit_manager.captureAdditionalData();
-            last_additional_data_capture = now;
+            screen_off_since = now;
+            screen_off_cleanup_pending = true;
+        } else if (is_screen_on) {
+            screen_off_cleanup_pending = false;
         }
     }
 
     void handleScreenOff() {
         // 屏幕关闭时，根据学习阶段和应用重要性智能清理
         auto intensity = habit_manager.getLearningIntensity();
+        auto cleanup = [this](Target& target) {
+            trace.decision(target.package_name, TargetAction::KILL, TargetAction::NONE,
+                std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - target.last_background_time).count(), 0);
+            killProcess(target);
+        };
         
         // 仅在稳定阶段或低学习强度时执行智能清理
         if (intensity == UserHabitManager::LearningIntensity::STABLE ||
             intensity == UserHabitManager::LearningIntensity::LOW) {
             for (auto& target : targets) {
                 if (!target.is_foreground) {
+                    if (interval_manager.isLikelyNext(target.package_name)) {
+                        Logger::log(Logger::Level::INFO, std::format("Keeping {} on screen off: likely to be opened next",
+                            target.package_name));
+                        continue;
+                    }
                     // 检查应用重要性
                     auto it = habit_manager.getHabits().app_stats.find(target.package_name);
                     if (it != habit_manager.getHabits().app_stats.end()) {
-                        double importance = it->second.importance_weight;
-                        if (importance < 30.0) {  // 只杀死不太重要的应用
-                            killProcess(target.process_names[0], target.package_name);
+                        double importance = it->second.importanceWeight();
+                        if (importance < interval_manager.table().screen_off_keep_importance) {  // 只杀死不太重要的应用
+                            cleanup(target);
                         }
                     } else {
                         // 未知应用，默认杀死
-                        killProcess(target.process_names[0], target.package_name);
+                        cleanup(target);
                     }
                 }
             }
         } else {
             // 学习阶段，更保守的清理策略
             for (auto& target : targets) {
-                if (!target.is_foreground && !target.is_sticky) {
-                    killProcess(target.process_names[0], target.package_name);
+                if (!target.is_foreground && !target.is_sticky &&
+                    !interval_manager.isLikelyNext(target.package_name)) {
+                    cleanup(target);
                 }
             }
         }
-        
-        std::this_thread::sleep_for(interval_manager.getScreenOffSleepInterval());
     }
 
-    void checkProcesses() {
-        bool any_active = false;
-        std::vector<std::string> active_apps;
+    // 单个目标本周期的探测结果与决策
+    // 限制类动作之后仍可继续回收内存或调整优先级，杀死进程则不再有后续动作
+    struct TargetDecision {
+        TargetAction enforcement{ TargetAction::NONE };
+        TargetAction maintenance{ TargetAction::NONE };
+    };
+
+    struct TargetProbe {
+        Target* target;
+        bool should_check;
+        bool foreground;
+        TargetDecision decision;
+    };
+
+    // 返回下次检查前的等待时间
+    std::chrono::seconds checkProcesses() {
         auto check_start_time = std::chrono::steady_clock::now();
 
-        for (auto& target : targets) {
-            try {
-                bool should_check = shouldCheckProcesses(target.package_name);
-                if (should_check || target.is_foreground) {
-                    bool current_foreground = isProcessForeground(target.package_name);
-                    bool should_kill = false;
+        // 探测阶段：前台状态每周期读取一次，阻塞型探测分发到线程池并行执行
+        refreshForegroundState();
+        observeForegroundTransitions();
 
-                    auto now = std::chrono::steady_clock::now();
-                    int duration = std::chrono::duration_cast<std::chrono::seconds>(
-                        now - target.last_switch_time).count();
+        std::vector<TargetProbe> probes;
+        for (auto& target : targets) {
+            target.check_interval = interval_manager.getProcessCheckInterval(target.package_name);
+            target.kill_interval = interval_manager.getKillInterval(target.package_name);
+            target.reclaim_interval = interval_manager.getReclaimInterval(target.package_name);
+            bool should_check = shouldCheckProcesses(target);
+            if (!should_check && !target.is_foreground) continue;
 
-                    // 收集资源使用情况
-                    collectProcessResourceUsage(target);
-                    
-                    // 状态变化处理
-                    if (current_foreground != target.is_foreground) {
-                        // 更新状态
-                        target.is_foreground = current_foreground;
-                        target.last_switch_time = now;
-                        
-                        if (!current_foreground) {
-                            // 从前台切换到后台
-                            target.last_background_time = now;
-                        }
-                        
-                        target.switch_count++;
-                        habit_manager.updateAppStats(target.package_name, current_foreground, duration);
-                        
-                        Logger::log(Logger::Level::INFO, "Package " + target.package_name +
-                            (current_foreground ? " moved to foreground" : " moved to background"));
-                    }
+            probes.push_back({ &target, should_check, isProcessForeground(target.package_name), {} });
+            // 上次超时的探测仍在执行时不重复提交，避免慢探测在线程池中堆积
+            if (resourceSampleDue(target, check_start_time) && !target.memory_probe.valid()) {
+                target.memory_probe = probe_pool.submit([package_name = target.package_name] {
+                    return probeMemoryKb(package_name);
+                });
+            }
+        }
 
-                    // 确定是否应该杀死进程
-                    if (!current_foreground && !target.is_foreground && should_check && !target.is_sticky) {
-                        auto background_duration = now - target.last_background_time;
-                        auto kill_interval = interval_manager.getKillInterval(target.package_name);
-                        
-                        // 检查内存和CPU使用情况
-                        bool resource_heavy = target.memory_usage_kb > 150000 || target.cpu_usage_percent > 5;
-                        
-                        // 根据资源使用情况调整kill间隔
-                        if (resource_heavy) {
-                            kill_interval = std::chrono::duration_cast<std::chrono::seconds>(
-                                kill_interval * 0.7); // 对资源占用高的应用更积极清理
-                        }
-                        
-                        if (background_duration >= kill_interval) {
-                            should_kill = true;
-                            Logger::log(Logger::Level::INFO, 
-                                std::format("Killing {} - background for {}s, memory: {}KB, CPU: {}%", 
-                                target.package_name, 
-                                std::chrono::duration_cast<std::chrono::seconds>(background_duration).count(),
-                                target.memory_usage_kb,
-                                target.cpu_usage_percent));
+        // 汇总阶段：等待探测结果，超时的探测保留上次的数值
+        auto probe_deadline = std::chrono::steady_clock::now() + PROBE_TIMEOUT + PROBE_GRACE;
+        for (auto& probe : probes) {
+            auto& target = *probe.target;
+            try {
+                if (target.memory_probe.valid()) {
+                    if (target.memory_probe.wait_until(probe_deadline) == std::future_status::ready) {
+                        if (auto memory_kb = target.memory_probe.get()) {
+                            target.memory_usage_kb = *memory_kb;
                         }
+                    } else {
+                        stats.probe_timeouts++;
+                        Logger::log(Logger::Level::WARN, std::format("Memory probe for {} timed out", target.package_name));
                     }
+                }
+                if (resourceSampleDue(target, check_start_time)) {
+                    collectProcessResourceUsage(target);
+                }
+                updateForegroundState(target, probe.foreground);
+            } catch (const std::exception& e) {
+                Logger::log(Logger::Level::ERROR,
+                    std::format("Error probing target {}: {}", target.package_name, e.what()));
+            }
+        }
+        auto probe_duration = std::chrono::steady_clock::now() - check_start_time;
 
-                    // 执行杀死进程
-                    if (should_kill) {
-                        killProcess(target.process_names[0], target.package_name);
-                    } else if (should_check) {
-                        // 调整进程优先级
-                        adjustProcessPriority(target);
-                    }
+        // 决策阶段：只读取已合并的状态
+        for (auto& probe : probes) {
+            probe.decision = decideActions(*probe.target, probe.should_check, probe.foreground);
+            const auto& target = *probe.target;
+            if (probe.should_check && trace.active()) {
+                trace.decision(target.package_name, probe.decision.enforcement, probe.decision.maintenance,
+                    target.is_foreground ? -1 : std::chrono::duration_cast<std::chrono::seconds>(
+                        std::chrono::steady_clock::now() - target.last_background_time).count(),
+                    target.kill_interval.count());
+            }
+        }
 
-                    // 记录活跃应用
-                    if (current_foreground) {
-                        any_active = true;
-                        active_apps.push_back(target.package_name);
-                    }
-                }
+        // 执行阶段
+        std::string first_active;
+        for (auto& probe : probes) {
+            auto& target = *probe.target;
+            try {
+                applyAction(target, probe.decision.enforcement);
+                applyAction(target, probe.decision.maintenance);
             } catch (const std::exception& e) {
                 Logger::log(Logger::Level::ERROR,
                     std::format("Error processing target {}: {}", target.package_name, e.what()));
             }
+            if (probe.foreground && first_active.empty()) {
+                first_active = target.package_name;
+            }
         }
 
         // 更新检查时长统计
@@ -1502,19 +6341,222 @@ private:
         double duration_ms = std::chrono::duration_cast<std::chrono::milliseconds>(check_duration).count();
         stats.total_check_cycles++;
         stats.avg_check_duration_ms = (stats.avg_check_duration_ms * (stats.total_check_cycles - 1) + duration_ms) / stats.total_check_cycles;
+        stats.max_probe_duration_ms = std::max<double>(stats.max_probe_duration_ms,
+            std::chrono::duration_cast<std::chrono::milliseconds>(probe_duration).count());
         
-        // 根据当前活跃状态和检查耗时决定下次检查间隔
-        auto sleep_time = any_active ?
-            interval_manager.getProcessCheckInterval(active_apps.empty() ? "" : active_apps[0]) :
+        // 根据当前活跃状态决定下次检查间隔；探测并行且有超时，周期耗时有上限，无需再拉长间隔
+        return !first_active.empty() ?
+            interval_manager.getProcessCheckInterval(first_active) :
             interval_manager.getScreenCheckInterval();
-            
-        // 如果检查耗时过长，适当增加休眠时间以减少CPU占用
-        if (duration_ms > 200) {
-            sleep_time = std::chrono::duration_cast<std::chrono::seconds>(
-                sleep_time * 1.2); // 增加20%的休眠时间
+    }
+
+    void updateForegroundState(Target& target, bool current_foreground) {
+        if (current_foreground == target.is_foreground) return;
+
+        auto now = std::chrono::steady_clock::now();
+        int duration = std::chrono::duration_cast<std::chrono::seconds>(now - target.last_switch_time).count();
+        target.is_foreground = current_foreground;
+        target.last_switch_time = now;
+
+        if (!current_foreground) {
+            // 从前台切换到后台
+            target.last_background_time = now;
+        }
+        target.memory_reclaimed = false;
+        if (current_foreground) {
+            // 回到前台：解冻并重置CPU预算
+            if (target.is_frozen) {
+                thawTarget(target);
+            }
+            target.budget_enforced = false;
+            target.traffic_enforced = false;
+            target.cpu_budget.reset(now);
         }
+
+        target.switch_count++;
+        habit_manager.updateAppStats(target.package_name, current_foreground, duration);
+
+        Logger::log(Logger::Level::INFO, "Package " + target.package_name +
+            (current_foreground ? " moved to foreground" : " moved to background"));
+    }
+
+    TargetDecision decideActions(const Target& target, bool should_check, bool current_foreground) {
+        TargetDecision decision;
+        if (!should_check) return decision;
+
+        auto now = std::chrono::steady_clock::now();
+        // 确定是否应该杀死进程
+        if (!current_foreground && !target.is_sticky) {
+            auto background_duration = now - target.last_background_time;
+            auto kill_interval = target.kill_interval;
+            
+            // 检查内存和CPU使用情况
+            const auto& table = interval_manager.table();
+            bool resource_heavy = target.memory_usage_kb > table.heavy_memory_kb ||
+                                  target.cpu_usage_percent > table.heavy_cpu_percent;
+            
+            // 根据资源使用情况调整kill间隔
+            if (resource_heavy) {
+                kill_interval = std::chrono::duration_cast<std::chrono::seconds>(
+                    kill_interval * table.heavy_kill_factor); // 对资源占用高的应用更积极清理
+            }
+
+            // 后台内存持续增长（疑似泄漏）时提前清理
+            if (target.series.leaking(static_cast<uint32_t>(time(nullptr)),
+                                      static_cast<uint32_t>(std::max(0, target.memory_usage_kb)))) {
+                kill_interval = std::chrono::duration_cast<std::chrono::seconds>(kill_interval * table.leak_kill_factor);
+            }
             
-        std::this_thread::sleep_for(sleep_time);
+            if (target.cpu_budget.exhausted() && !target.budget_enforced) {
+                decision.enforcement = TargetAction::ENFORCE_CPU_BUDGET;
+            } else if ((target.io_over_limit_samples >= 2 || target.net_over_limit_samples >= 2) &&
+                       !target.traffic_enforced) {
+                decision.enforcement = TargetAction::ENFORCE_TRAFFIC;
+            } else if (background_duration >= kill_interval) {
+                Logger::log(Logger::Level::INFO, 
+                    std::format("Killing {} - background for {}s, memory: {}KB, CPU: {}%", 
+                    target.package_name, 
+                    std::chrono::duration_cast<std::chrono::seconds>(background_duration).count(),
+                    target.memory_usage_kb,
+                    target.cpu_usage_percent));
+                decision.enforcement = TargetAction::KILL;
+                return decision;
+            }
+        }
+
+        if (!current_foreground && !target.memory_reclaimed &&
+            now - target.last_background_time >= target.reclaim_interval) {
+            // 后台一段时间但尚未到杀死时机，先回收内存
+            decision.maintenance = TargetAction::RECLAIM;
+        } else {
+            // 调整进程优先级
+            decision.maintenance = TargetAction::ADJUST_PRIORITY;
+        }
+        return decision;
+    }
+
+    void applyAction(Target& target, TargetAction action) {
+        switch (action) {
+            case TargetAction::ENFORCE_CPU_BUDGET: enforceCpuBudget(target); break;
+            case TargetAction::ENFORCE_TRAFFIC: enforceTrafficLimits(target); break;
+            case TargetAction::KILL: killProcess(target); break;
+            case TargetAction::RECLAIM: reclaimTargetMemory(target); break;
+            case TargetAction::ADJUST_PRIORITY: adjustProcessPriority(target); break;
+            case TargetAction::NONE: break;
+        }
+    }
+
+    // 周期任务：每个任务执行后按自身间隔和允许的延迟重新排期，调度器合并重叠的窗口
+    void registerTasks() {
+        screen_task = scheduler.add("screen", [this] { runScreenTask(); });
+        process_task = scheduler.add("processes", [this] { runProcessTask(); });
+        cleanup_task = scheduler.add("screen_off_cleanup", [this] { runScreenOffCleanup(); });
+        // 采集只在亮屏时有意义，息屏时取消，亮屏后重新排程
+        capture_task = scheduler.add("data_capture", [this] {
+            habit_manager.captureAdditionalData();
+            scheduler.schedule(capture_task, DATA_CAPTURE_INTERVAL, DATA_CAPTURE_INTERVAL / 3);
+        });
+        habit_task = scheduler.add("habit_save", [this] {
+            habit_manager.checkAndSaveHabits();
+            scheduleHabitSave();
+        });
+        history_task = scheduler.add("history_save", [this] {
+            if (history_dirty) saveResourceHistory();
+            scheduler.schedule(history_task, HISTORY_SAVE_INTERVAL, HISTORY_SAVE_INTERVAL / 2);
+        });
+        power_task = scheduler.add("power", [this] {
+            updateSuppressionProfile();
+            scheduler.schedule(power_task, POWER_CHECK_INTERVAL, POWER_CHECK_INTERVAL);
+        });
+        stats_task = scheduler.add("stats_dump", [this] {
+            dumpStatistics();
+            scheduler.schedule(stats_task, STATS_DUMP_INTERVAL, std::chrono::hours(1));
+        });
+        trace_task = scheduler.add("trace_flush", [this] { trace.flush(); });
+
+        auto zero = WakeupScheduler::Clock::duration::zero();
+        scheduler.schedule(screen_task, zero, zero);
+        scheduler.schedule(power_task, zero, zero);
+        scheduler.schedule(process_task, zero, zero);
+        scheduler.schedule(capture_task, DATA_CAPTURE_INTERVAL, DATA_CAPTURE_INTERVAL / 3);
+        scheduleHabitSave();
+        scheduler.schedule(history_task, HISTORY_SAVE_INTERVAL, HISTORY_SAVE_INTERVAL / 2);
+        scheduler.schedule(stats_task, STATS_DUMP_INTERVAL, std::chrono::hours(1));
+    }
+
+    // 息屏时习惯数据几乎不变，放宽到可与电源、历史保存等任务合并唤醒
+    void scheduleHabitSave() {
+        if (is_screen_on) {
+            scheduler.schedule(habit_task, HABIT_SAVE_INTERVAL, HABIT_SAVE_INTERVAL);
+        } else {
+            scheduler.schedule(habit_task, HABIT_SAVE_INTERVAL * 2, SCREEN_OFF_HABIT_SAVE_SLACK);
+        }
+    }
+
+    // 充电时放宽、低电量或过热时收紧：缩放各类间隔与 CPU 预算、流量上限
+    void updateSuppressionProfile() {
+        auto state = PowerStateReader::read();
+        auto profile = profile_selector.update(state);
+        trace.power(state, profile);
+        if (profile == interval_manager.profile()) return;
+
+        interval_manager.setProfile(profile);
+        double scale = interval_manager.throttleScale();
+        for (auto& target : targets) {
+            target.cpu_budget.resize(target.policy.cpu_budget_seconds * scale, target.policy.cpu_budget_window);
+        }
+        Logger::log(Logger::Level::INFO, std::format(
+            "Suppression profile {}: battery {}%{}, battery {:.1f}°C, thermal {:.1f}°C",
+            profileName(profile), state.battery_level, state.charging ? " charging" : "",
+            state.battery_temp_c, state.max_thermal_c));
+    }
+
+    void runScreenTask() {
+        bool was_screen_on = is_screen_on;
+        checkScreenState();
+
+        if (is_screen_on && !was_screen_on) {
+            if (activity_monitor.active()) refreshScreenOffTimeout();
+            scheduler.runSoon(process_task);
+            scheduler.schedule(capture_task, DATA_CAPTURE_INTERVAL, DATA_CAPTURE_INTERVAL / 3);
+            scheduleHabitSave();
+        } else if (!is_screen_on && was_screen_on) {
+            // 息屏后不再周期检查进程与采集数据，只保留清理和低频任务
+            scheduler.cancel(process_task);
+            scheduler.cancel(capture_task);
+            scheduleHabitSave();
+        }
+        if (screen_off_cleanup_pending && !scheduler.scheduled(cleanup_task)) {
+            scheduler.schedule(cleanup_task, SCREEN_OFF_CLEANUP_IDLE, std::chrono::seconds(30));
+        }
+
+        if (is_screen_on) {
+            auto interval = interval_manager.getScreenCheckInterval();
+            scheduler.schedule(screen_task, interval, interval / 4);
+        } else if (activity_monitor.active()) {
+            scheduler.schedule(screen_task, MONITORED_SCREEN_POLL, MONITORED_SCREEN_POLL / 2);
+        } else {
+            // 没有输入监听时只能轮询亮屏，允许较大延迟以便与其他任务合并
+            auto interval = interval_manager.getScreenOffSleepInterval();
+            scheduler.schedule(screen_task, interval, interval / 2);
+        }
+    }
+
+    void runProcessTask() {
+        if (!is_screen_on) return;
+        auto delay = checkProcesses();
+        scheduler.schedule(process_task, delay, delay / 4);
+    }
+
+    void runScreenOffCleanup() {
+        if (is_screen_on || !screen_off_cleanup_pending) return;
+        auto idle = userIdleTime();
+        if (idle < SCREEN_OFF_CLEANUP_IDLE) {
+            scheduler.schedule(cleanup_task, SCREEN_OFF_CLEANUP_IDLE - idle, std::chrono::seconds(30));
+            return;
+        }
+        screen_off_cleanup_pending = false;
+        handleScreenOff();
     }
     
     void dumpStatistics() {
@@ -1529,13 +6571,64 @@ private:
             "Total processes killed: {}", stats.total_processes_killed));
         Logger::log(Logger::Level::INFO, std::format(
             "Average check duration: {:.2f}ms", stats.avg_check_duration_ms));
+        Logger::log(Logger::Level::INFO, std::format(
+            "Probe stage: max {:.0f}ms, {} timeouts, {} workers",
+            stats.max_probe_duration_ms, stats.probe_timeouts, probe_pool.size()));
+        Logger::log(Logger::Level::INFO, std::format(
+            "Commands spawned: {}, timed out: {}", CommandRunner::spawnCount(), CommandRunner::timeoutCount()));
+        Logger::log(Logger::Level::INFO, std::format(
+            "Wakeups: {} total, {} in the last hour, {:.2f} tasks per wakeup",
+            scheduler.wakeups(), scheduler.wakeupsLastHour(), scheduler.tasksPerWakeup()));
+        Logger::log(Logger::Level::INFO, std::format(
+            "Total memory freed by kills: {}KB", stats.total_bytes_freed / 1024));
+        Logger::log(Logger::Level::INFO, std::format(
+            "Total memory reclaimed: {}KB in {} actions",
+            stats.total_bytes_reclaimed / 1024, stats.total_reclaim_actions));
         
         // 输出每个应用的杀死次数
         std::string kill_stats = "Kill counts by package: ";
         for (const auto& [pkg, count] : stats.killed_count_by_package) {
-            kill_stats += pkg + "(" + std::to_string(count) + ") ";
+            kill_stats += pkg + "(" + std::to_string(count) + ", " +
+                std::to_string(stats.freed_bytes_by_package[pkg] / 1024) + "KB) ";
         }
         Logger::log(Logger::Level::INFO, kill_stats);
+
+        Logger::log(Logger::Level::INFO, std::format(
+            "CPU budget enforcements: {}", stats.total_budget_enforcements));
+        for (const auto& [pkg, count] : stats.budget_enforcements_by_package) {
+            Logger::log(Logger::Level::INFO, std::format("  {}: {} budget enforcements", pkg, count));
+        }
+        Logger::log(Logger::Level::INFO, std::format(
+            "I/O and network limit enforcements: {}", stats.total_traffic_enforcements));
+        for (const auto& target : targets) {
+            Logger::log(Logger::Level::INFO, std::format(
+                "  {}: io r/w {:.1f}/{:.1f}KB/s, net rx/tx {:.1f}/{:.1f}KB/s", target.package_name,
+                target.io_read_rate / 1024.0, target.io_write_rate / 1024.0,
+                target.net_rx_rate / 1024.0, target.net_tx_rate / 1024.0));
+        }
+
+        std::string reclaim_stats = "Reclaimed KB by package: ";
+        for (const auto& [pkg, bytes] : stats.reclaimed_bytes_by_package) {
+            reclaim_stats += pkg + "(" + std::to_string(bytes / 1024) + ") ";
+        }
+        Logger::log(Logger::Level::INFO, reclaim_stats);
+
+        collectKillOutcomes();
+        for (const auto& [pkg, outcomes] : stats.outcomes_by_package) {
+            Logger::log(Logger::Level::INFO, std::format(
+                "  {}: {} kills measured ({} unconfirmed), latency p50/p95 {}/{}ms, freed p50 {}KB vs PSS p50 {}KB "
+                "(effectiveness {:.2f}), reclaim p50 {}KB over {} actions",
+                pkg, outcomes.kill_latency_ms.count(), outcomes.kills_unconfirmed,
+                outcomes.kill_latency_ms.quantile(0.5), outcomes.kill_latency_ms.quantile(0.95),
+                outcomes.kill_freed_kb.quantile(0.5), outcomes.kill_pss_kb.quantile(0.5), outcomes.killEffectiveness(),
+                outcomes.reclaim_kb.quantile(0.5), outcomes.reclaim_kb.count()));
+        }
+        
+        auto writer_stats = habit_manager.writerStats();
+        Logger::log(Logger::Level::INFO, std::format(
+            "Habit saves: {} ({} coalesced, {} failed), latency last/avg/max {:.1f}/{:.1f}/{:.1f}ms, max queue wait {:.1f}ms",
+            writer_stats.saves, writer_stats.coalesced, writer_stats.failures,
+            writer_stats.last_ms, writer_stats.avg_ms, writer_stats.max_ms, writer_stats.max_queue_ms));
         
         // 输出学习状态
         Logger::log(Logger::Level::INFO, std::format(
@@ -1545,60 +6638,81 @@ private:
     }
 
 public:
-    explicit ProcessManager(const std::vector<std::pair<std::string, std::vector<std::string>>>& initial_targets)
+    ProcessManager(const std::vector<TargetConfig>& initial_targets, const DaemonOptions& options, Policy policy = {})
         : start_time(std::chrono::steady_clock::now()),
-          last_additional_data_capture(std::chrono::steady_clock::now()),
-          interval_manager(habit_manager.getHabits(), habit_manager) {
-        for (const auto& [pkg, procs] : initial_targets) {
-            if (!pkg.empty() && !procs.empty()) {
-                targets.emplace_back(pkg, procs);
-                Logger::log(Logger::Level::INFO, std::format("Added target: {} with {} processes", pkg, procs.size()));
+          habit_manager(options.module_dir),
+          interval_manager(habit_manager.getHabits(), habit_manager, std::move(policy)) {
+        for (const auto& config : initial_targets) {
+            if (!config.package_name.empty() && !config.process_names.empty()) {
+                auto& target = targets.emplace_back(config.package_name, config.process_names);
+                target.policy = config.policy;
+                target.cpu_budget.configure(target.policy.cpu_budget_seconds, target.policy.cpu_budget_window);
+                Logger::log(Logger::Level::INFO, std::format("Added target: {} with {} processes",
+                    config.package_name, config.process_names.size()));
                 stats.total_processes_managed++;
             }
         }
-        
+        package_index.open(options.packages_list_path);
+        // 先按上限淘汰本地记录，再导入先验，导入时按同一上限淘汰
+        habit_manager.setCapacity(options.max_habit_apps);
+        habit_manager.importPriors(options.habit_priors_path);
+        status_page.open(options.status_path);
+        history_path = options.history_path;
+        if (!options.trace_path.empty()) {
+            trace.open(options.trace_path, options.trace_max_bytes);
+        }
+        auto history = ResourceHistoryFile::load(history_path);
+        for (auto& target : targets) {
+            auto it = history.find(target.package_name);
+            if (it != history.end()) {
+                target.series = std::move(it->second);
+            }
+        }
         stats.start_time = start_time;
     }
 
     void start() {
-        Logger::log(Logger::Level::INFO, std::format("Process manager started with {} targets", targets.size()));
+        Logger::log(Logger::Level::INFO, std::format("Process manager started with {} targets, {} policy",
+            targets.size(), policyName(Policy::KIND)));
         last_screen_check = std::chrono::steady_clock::now();
-        std::chrono::steady_clock::time_point last_stats_dump = start_time;
+        ShutdownSignal::install(scheduler.wakeFd());
+        registerTasks();
+        startActivityMonitor();
+        Logger::log(Logger::Level::INFO, foreground_detector.available() ?
+            "Using top-app cpuset for foreground detection" :
+            "top-app cpuset unavailable, using dumpsys window for foreground detection");
 
-        while (running) {
-            try {
-                // 检查屏幕状态
-                checkScreenState();
-                
-                // 根据屏幕状态决定行为
-                if (is_screen_on) {
-                    checkProcesses();
-                } else {
-                    // 屏幕关闭时使用较长的休眠时间
-                    std::this_thread::sleep_for(interval_manager.getScreenOffSleepInterval());
-                }
-                
-                // 定期输出统计信息
-                auto now = std::chrono::steady_clock::now();
-                if (now - last_stats_dump > std::chrono::hours(6)) {
-                    dumpStatistics();
-                    last_stats_dump = now;
-                }
-                
-            } catch (const std::exception& e) {
-                Logger::log(Logger::Level::ERROR, std::format("Error in main loop: {}", e.what()));
-                std::this_thread::sleep_for(std::chrono::seconds(10)); // 错误恢复延迟
+        while (running && !ShutdownSignal::requested()) {
+            // 每批任务执行前汇总已完成的杀死结果并发布状态，读者无需唤醒守护进程
+            collectKillOutcomes();
+            publishStatus();
+            scheduler.runOnce();
+            trace.flush();
+            // 缓冲未写满时按最早记录的停留上限安排一次写入，息屏长间隔下也不会积压
+            if (auto delay = trace.flushDelay(); delay && !scheduler.scheduled(trace_task)) {
+                scheduler.schedule(trace_task, *delay, WakeupScheduler::Clock::duration::zero());
             }
         }
+        if (ShutdownSignal::requested()) {
+            Logger::log(Logger::Level::INFO, "Termination signal received, saving state");
+        }
+        saveResourceHistory();
+        // 习惯数据的最终保存与轨迹文件的关闭在析构时完成
+        stop();
     }
 
-    void stop() { running = false; }
+    void stop() {
+        running = false;
+        scheduler.interrupt();
+        activity_monitor.stop();
+    }
 };
 
+// 旧的命令行协议：包名与带 ':' 的进程名交替出现，仅在未指定 --config 时使用
 class ArgumentParser {
 public:
-    static std::vector<std::pair<std::string, std::vector<std::string>>> parse(int argc, char* argv[], int start_index) {
-        std::vector<std::pair<std::string, std::vector<std::string>>> result;
+    static std::vector<TargetConfig> parse(int argc, char* argv[], int start_index) {
+        std::vector<TargetConfig> result;
         std::string current_package;
         std::vector<std::string> current_processes;
 
@@ -1607,7 +6721,7 @@ public:
             if (arg.find(':') == std::string::npos) {
                 // 如果是package_name，先保存前一个package的信息
                 if (!current_package.empty()) {
-                    result.emplace_back(current_package, current_processes);
+                    result.push_back({ current_package, current_processes, {} });
                     current_processes.clear();
                 }
                 current_package = arg;
@@ -1621,37 +6735,174 @@ public:
         
         // 添加最后一个package的信息
         if (!current_package.empty() && !current_processes.empty()) {
-            result.emplace_back(current_package, current_processes);
+            result.push_back({ current_package, current_processes, {} });
         }
         return result;
     }
 };
 
+template <typename Policy>
+void runManager(const std::vector<TargetConfig>& targets, const DaemonOptions& options, Policy policy) {
+    ProcessManager<Policy> manager(targets, options, std::move(policy));
+    manager.start();
+}
+
+// 按 --policy 选择策略：内置策略各自实例化一份，其余视为策略表文件
+void runWithPolicy(const std::vector<TargetConfig>& targets, const DaemonOptions& options) {
+    if (options.policy == "aggressive") {
+        runManager(targets, options, BuiltinPolicy<PolicyKind::AGGRESSIVE>{});
+    } else if (options.policy == "conservative") {
+        runManager(targets, options, BuiltinPolicy<PolicyKind::CONSERVATIVE>{});
+    } else if (options.policy == "balanced") {
+        runManager(targets, options, BuiltinPolicy<PolicyKind::BALANCED>{});
+    } else if (auto table = TablePolicy::load(options.policy)) {
+        runManager(targets, options, *table);
+    } else {
+        Logger::log(Logger::Level::WARN, "Falling back to balanced policy");
+        runManager(targets, options, BuiltinPolicy<PolicyKind::BALANCED>{});
+    }
+}
+
 int main(int argc, char* argv[]) {
+    // 只读子命令：打印状态页，不启动守护进程也不写日志
+    if (argc >= 2 && strcmp(argv[1], "--status") == 0) {
+        DaemonOptions options;
+        std::string path = argc >= 3 ? argv[2] : options.status_path;
+        auto status = StatusPage::read(path);
+        if (!status) {
+            fprintf(stderr, "No readable status page at %s\n", path.c_str());
+            return 1;
+        }
+        printf("%s\n", status->dump(2).c_str());
+        return 0;
+    }
+
+    // 只读子命令：输出资源历史 --history [--module-dir <dir>] [--history-file <path>] [包名] [hour|day|week]
+    if (argc >= 2 && strcmp(argv[1], "--history") == 0) {
+        DaemonOptions options;
+        std::string history_file;
+        std::vector<std::string> positional;
+        for (int i = 2; i < argc; ++i) {
+            if (strcmp(argv[i], "--module-dir") == 0 && i + 1 < argc) {
+                options.setModuleDir(argv[++i]);
+            } else if (strcmp(argv[i], "--history-file") == 0 && i + 1 < argc) {
+                history_file = argv[++i];
+            } else {
+                positional.push_back(argv[i]);
+            }
+        }
+        if (!history_file.empty()) options.history_path = history_file;
+        std::string package = positional.size() >= 1 ? positional[0] : "";
+        std::string range = positional.size() >= 2 ? positional[1] : "day";
+        auto now = static_cast<uint32_t>(time(nullptr));
+        nlohmann::json j = nlohmann::json::object();
+        for (const auto& [name, series] : ResourceHistoryFile::load(options.history_path)) {
+            if (!package.empty() && name != package) continue;
+            auto trend = series.memoryTrend(now);
+            j[name] = series.toJson(range);
+            j[name]["memory_trend"] = { { "kb_per_hour", trend.kb_per_hour }, { "r2", trend.r2 }, { "samples", trend.samples } };
+        }
+        printf("%s\n", j.dump(2).c_str());
+        return 0;
+    }
+
+    // 离线子命令：解析运行轨迹 --trace-dump <path> [--package <包名>] [--type <类型>] [--since <Unix秒>] [--until <Unix秒>]
+    if (argc >= 3 && strcmp(argv[1], "--trace-dump") == 0) {
+        TraceRecorder::DumpFilter filter;
+        for (int i = 3; i < argc; i += 2) {
+            bool known = strcmp(argv[i], "--package") == 0 || strcmp(argv[i], "--type") == 0 ||
+                         strcmp(argv[i], "--since") == 0 || strcmp(argv[i], "--until") == 0;
+            if (known && i + 1 >= argc) {
+                fprintf(stderr, "Missing value for %s\n"
+                    "Usage: %s --trace-dump <path> [--package <name>] [--type <type>] [--since <unix>] [--until <unix>]\n",
+                    argv[i], argv[0]);
+                return 1;
+            }
+            if (strcmp(argv[i], "--package") == 0) {
+                filter.package = argv[i + 1];
+            } else if (strcmp(argv[i], "--type") == 0) {
+                filter.type = argv[i + 1];
+            } else if (strcmp(argv[i], "--since") == 0) {
+                filter.since_ms = strtoll(argv[i + 1], nullptr, 10) * 1000;
+            } else if (strcmp(argv[i], "--until") == 0) {
+                filter.until_ms = strtoll(argv[i + 1], nullptr, 10) * 1000;
+            } else {
+                fprintf(stderr, "Unknown option: %s\n", argv[i]);
+                return 1;
+            }
+        }
+        return TraceRecorder::dump(argv[2], filter);
+    }
+
+    // 模块目录决定日志位置，需在初始化日志前确定；夹具根目录决定默认路径，需在解析其余参数前确定
+    DaemonOptions options;
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (strcmp(argv[i], "--module-dir") == 0) options.setModuleDir(argv[i + 1]);
+        if (strcmp(argv[i], "--fixture-root") == 0) options.setFixtureRoot(argv[i + 1]);
+    }
+
     try {
-        Logger::init();
+        Logger::init(options.module_dir + "/logs");
         Logger::log(Logger::Level::INFO, "Process manager starting...");
+        if (!options.fixture_root.empty()) {
+            SystemProbe::install(std::make_unique<FixtureSystemProbe>(options.fixture_root));
+            Logger::log(Logger::Level::INFO, std::format("System probe: {} (root {})",
+                SystemProbe::current().name(), SystemProbe::current().root()));
+        }
 
         if (argc < 3) {
-            Logger::log(Logger::Level::ERROR, std::format("Usage: {} [-d] <package_name_1> <process_name_1> [<package_name_2> <process_name_1> ...]", argv[0]));
+            Logger::log(Logger::Level::ERROR, std::format("Usage: {} [-d] [--module-dir <dir>] [--fixture-root <dir>] [--packages-list <path>] [--max-habit-apps <n>] [--habit-priors <path>] [--status-file <path>] [--history-file <path>] "
+                "[--policy <balanced|aggressive|conservative|policy.json>] [--trace <path>] [--trace-size-kb <n>] "
+                "(--config <suppress_config.json> | <package_name_1> <process_name_1> [<package_name_2> <process_name_1> ...])", argv[0]));
             return 1;
         }
 
+        bool daemonize = false;
         int arg_offset = 1;
-        if (strcmp(argv[1], "-d") == 0) {
-            arg_offset = 2;
+        while (arg_offset < argc && argv[arg_offset][0] == '-') {
+            if (strcmp(argv[arg_offset], "-d") == 0) {
+                daemonize = true;
+            } else if (strcmp(argv[arg_offset], "--packages-list") == 0 && arg_offset + 1 < argc) {
+                options.packages_list_path = argv[++arg_offset];
+            } else if ((strcmp(argv[arg_offset], "--module-dir") == 0 || strcmp(argv[arg_offset], "--fixture-root") == 0) &&
+                       arg_offset + 1 < argc) {
+                arg_offset++;  // 已在初始化日志前处理
+            } else if (strcmp(argv[arg_offset], "--config") == 0 && arg_offset + 1 < argc) {
+                options.config_path = argv[++arg_offset];
+            } else if (strcmp(argv[arg_offset], "--history-file") == 0 && arg_offset + 1 < argc) {
+                options.history_path = argv[++arg_offset];
+            } else if (strcmp(argv[arg_offset], "--status-file") == 0 && arg_offset + 1 < argc) {
+                options.status_path = argv[++arg_offset];
+            } else if (strcmp(argv[arg_offset], "--habit-priors") == 0 && arg_offset + 1 < argc) {
+                options.habit_priors_path = argv[++arg_offset];
+            } else if (strcmp(argv[arg_offset], "--trace") == 0 && arg_offset + 1 < argc) {
+                options.trace_path = argv[++arg_offset];
+            } else if (strcmp(argv[arg_offset], "--trace-size-kb") == 0 && arg_offset + 1 < argc) {
+                options.trace_max_bytes = std::strtoul(argv[++arg_offset], nullptr, 10) * 1024;
+            } else if (strcmp(argv[arg_offset], "--policy") == 0 && arg_offset + 1 < argc) {
+                options.policy = argv[++arg_offset];
+            } else if (strcmp(argv[arg_offset], "--max-habit-apps") == 0 && arg_offset + 1 < argc) {
+                options.max_habit_apps = std::strtoul(argv[++arg_offset], nullptr, 10);
+            } else {
+                Logger::log(Logger::Level::WARN, std::format("Unknown option: {}", argv[arg_offset]));
+            }
+            arg_offset++;
+        }
+
+        if (daemonize) {
             if (fork() > 0) return 0;
             setsid();
         }
 
-        auto targets = ArgumentParser::parse(argc, argv, arg_offset);
+        auto targets = options.config_path.empty() ?
+            ArgumentParser::parse(argc, argv, arg_offset) :
+            ConfigCache::load(options.config_path);
         if (targets.empty()) {
             Logger::log(Logger::Level::ERROR, "No valid targets specified");
             return 1;
         }
 
-        ProcessManager manager(targets);
-        manager.start();
+        runWithPolicy(targets, options);
     } catch (const std::exception& e) {
         Logger::log(Logger::Level::ERROR, "Fatal error: " + std::string(e.what()));
         return 1;
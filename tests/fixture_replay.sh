@@ -0,0 +1,75 @@
+#!/bin/sh
+# 在普通 Linux 上用 tests/fixture 回放完整的决策循环，检查 actions.log 中的动作：
+# 前台应用 com.example.chat 应被调整优先级，后台目标 com.example.sync 的整个进程树（3001 及其子进程 3002）应被杀死
+# 用法：tests/fixture_replay.sh <主机编译的 process_manager>
+set -eu
+
+bin="${1:?Usage: $0 <process_manager>}"
+here=$(cd "$(dirname "$0")" && pwd)
+work=$(mktemp -d)
+daemon=""
+cleanup() {
+    [ -n "$daemon" ] && kill "$daemon" 2>/dev/null || true
+    rm -rf "$work"
+}
+trap cleanup EXIT
+
+# 杀死会改写夹具（重命名 proc/<pid>），在副本上运行
+cp -R "$here/fixture" "$work/root"
+mkdir -p "$work/module/logs" "$work/module/module_settings"
+actions="$work/root/actions.log"
+
+"$bin" --module-dir "$work/module" --fixture-root "$work/root" --policy "$here/fixture_policy.json" \
+    com.example.chat com.example.chat:push com.example.sync com.example.sync:push &
+daemon=$!
+
+# 最多等待 30 秒，直到两个后台进程都被杀死
+i=0
+while [ $i -lt 30 ]; do
+    if grep -q '^[0-9]* 3001 signal 9$' "$actions" 2>/dev/null &&
+       grep -q '^[0-9]* 3002 signal 9$' "$actions" 2>/dev/null; then
+        break
+    fi
+    sleep 1
+    i=$((i + 1))
+done
+
+# SIGTERM 应让守护进程正常退出并保存状态
+kill -TERM "$daemon"
+status=0
+wait "$daemon" || status=$?
+daemon=""
+
+failed=0
+expect() {
+    if grep -q "$1" "$actions" 2>/dev/null; then
+        echo "ok: $2"
+    else
+        echo "FAIL: $2" >&2
+        failed=1
+    fi
+}
+expect '^[0-9]* 3001 signal 19$' "background target stopped before kill"
+expect '^[0-9]* 3001 signal 9$' "background target killed"
+expect '^[0-9]* 3002 signal 9$' "child of background target killed"
+expect '^[0-9]* 2002 nice ' "foreground target reprioritized"
+if grep -q '^[0-9]* 200[12] signal' "$actions" 2>/dev/null; then
+    echo "FAIL: foreground target was signalled" >&2
+    failed=1
+fi
+if [ "$status" -ne 0 ]; then
+    echo "FAIL: daemon exited with status $status" >&2
+    failed=1
+fi
+if ! grep -q 'Termination signal received' "$work/module/logs/process_manager.log"; then
+    echo "FAIL: daemon did not shut down through the signal handler" >&2
+    failed=1
+fi
+
+if [ $failed -ne 0 ]; then
+    echo "--- actions.log" >&2
+    cat "$actions" >&2 || true
+    echo "--- process_manager.log" >&2
+    tail -n 40 "$work/module/logs/process_manager.log" >&2 || true
+fi
+exit $failed
@@ -0,0 +1,62 @@
+// 主机端检查：切换模型为空时，星期×小时先验本身能否让习惯应用被视为即将打开
+// 编译：g++ -std=c++20 -O2 tests/likely_next_check.cpp -o likely_next_check -lpthread
+#define main process_manager_main
+#include "../src/process_manager.cpp"
+#undef main
+
+#include <filesystem>
+
+namespace {
+
+int failures = 0;
+
+void expect(bool condition, const std::string& what) {
+    std::printf("%s: %s\n", condition ? "ok" : "FAIL", what.c_str());
+    if (!condition) failures++;
+}
+
+template <PolicyKind Kind>
+void checkPolicy(const char* name, const UserHabitManager& habit_manager) {
+    UserHabits habits;
+    int today = getCurrentEpochDay();
+    int hour = getCurrentHour();
+    // 过去两周每天此时都打开
+    auto& habitual = habits.app_stats["com.example.habitual"].history;
+    // 过去两周每天都用，但从不在此时
+    auto& elsewhere = habits.app_stats["com.example.elsewhere"].history;
+    for (int day = today - 13; day <= today; ++day) {
+        habitual.recordOpen(day, hour);
+        elsewhere.recordOpen(day, (hour + 12) % 24);
+    }
+
+    IntervalManager<BuiltinPolicy<Kind>> intervals(habits, habit_manager);
+    expect(intervals.isLikelyNext("com.example.habitual"),
+        std::format("{}: habitual hour is likely next without transitions ({:.3f})",
+            name, intervals.nextUsageProbability("com.example.habitual")));
+    expect(!intervals.isLikelyNext("com.example.elsewhere"),
+        std::format("{}: app never used at this hour is not likely next ({:.3f})",
+            name, intervals.nextUsageProbability("com.example.elsewhere")));
+    expect(!intervals.isLikelyNext("com.example.unknown"),
+        std::format("{}: unknown app is not likely next", name));
+}
+
+} // namespace
+
+int main() {
+    char dir_template[] = "/tmp/likely_next_check.XXXXXX";
+    const char* module_dir = mkdtemp(dir_template);
+    if (!module_dir) {
+        perror("mkdtemp");
+        return 1;
+    }
+    std::string logs = std::string(module_dir) + "/logs";
+    mkdir(logs.c_str(), 0755);
+    {
+        UserHabitManager habit_manager(module_dir);
+        checkPolicy<PolicyKind::BALANCED>("balanced", habit_manager);
+        checkPolicy<PolicyKind::AGGRESSIVE>("aggressive", habit_manager);
+        checkPolicy<PolicyKind::CONSERVATIVE>("conservative", habit_manager);
+    }
+    std::filesystem::remove_all(module_dir);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,47 @@
+#!/bin/sh
+# 从已 root 的设备录制一份回放夹具，供 process_manager --fixture-root 使用
+# 用法：capture.sh <输出目录> <包名> [<包名> ...]
+# 需要 adb 且设备上 su 可用；录制的是当前时刻的快照，回放时可直接改写 commands/ 下的文件模拟状态变化
+set -e
+
+out="$1"
+shift || true
+if [ -z "$out" ] || [ $# -eq 0 ]; then
+    echo "Usage: $0 <output_dir> <package> [<package> ...]" >&2
+    exit 1
+fi
+
+# exec-out 不经过终端转换，保留 cmdline 中的 NUL
+su_cmd() {
+    adb exec-out "su -c '$1'"
+}
+
+mkdir -p "$out/commands" "$out/proc/net" "$out/data/system"
+
+su_cmd "dumpsys window" > "$out/commands/dumpsys_window"
+su_cmd "dumpsys display" > "$out/commands/dumpsys_display"
+su_cmd "dumpsys meminfo" > "$out/commands/dumpsys_meminfo"
+su_cmd "settings get system screen_off_timeout" > "$out/commands/settings_get_system_screen_off_timeout"
+su_cmd "cat /data/system/packages.list" > "$out/data/system/packages.list"
+su_cmd "cat /proc/net/dev" > "$out/proc/net/dev"
+su_cmd "cat /proc/meminfo" > "$out/proc/meminfo"
+
+for package in "$@"; do
+    su_cmd "dumpsys meminfo $package" > "$out/commands/dumpsys_meminfo_$package"
+    # 包名本身及其所有 "包名:子进程" 进程
+    pids=$(adb shell su <<EOS | tr -d '\r'
+for p in /proc/[0-9]*; do
+    n=\$(tr '\\0' '\\n' < \$p/cmdline 2>/dev/null | head -n 1)
+    case "\$n" in $package|$package:*) echo \${p#/proc/} ;; esac
+done
+EOS
+)
+    for pid in $pids; do
+        mkdir -p "$out/proc/$pid"
+        for file in cmdline stat status statm io cgroup oom_score_adj smaps_rollup; do
+            su_cmd "cat /proc/$pid/$file" > "$out/proc/$pid/$file" 2>/dev/null || true
+        done
+    done
+done
+
+echo "Fixture written to $out"
@@ -0,0 +1,481 @@
+// DeepSuppressor 桌面压测工具：在普通 Linux 上长时间运行守护进程并统计其自身开销
+//
+// 构建：g++ -std=c++20 -O2 -I<nlohmann 头文件目录> tools/soak/soak_harness.cpp -o soak_harness
+// 守护进程用主机编译器构建同一份 src/process_manager.cpp 即可。
+//
+// 运行：soak_harness --daemon <process_manager> [--hours <h>] [--apps <n>] [--procs-per-app <n>]
+//          [--mem-mb <n>] [--cpu-duty <0-100>] [--switch-seconds <n>] [--screen-on-minutes <n>]
+//          [--screen-off-minutes <n>] [--respawn-seconds <n>] [--report-minutes <n>]
+//          [--workdir <dir>] [--fixtures <dir>] [--report <file>] [-- <额外的守护进程参数>]
+//
+// 假应用是本程序以 argv[0] = "<包名>:<进程名>" 重新执行的子进程，占用内存并按占空比消耗 CPU，
+// 被守护进程杀死后按间隔重新拉起。dumpsys/settings 由 fixtures 目录下的脚本替代，
+// 焦点与屏幕状态写在 <workdir>/state 中。主机存在背光节点时守护进程会直接读取它，
+// 此时屏幕周期只影响 dumpsys 的回答。
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <sstream>
+#include <string>
+#include <sys/prctl.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace fs = std::filesystem;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+volatile sig_atomic_t g_stop = 0;
+
+struct Options {
+    std::string daemon;
+    std::string workdir{ "/tmp/deepsuppressor-soak" };
+    std::string fixtures;
+    std::string report_path;
+    double hours{ 1.0 };
+    int apps{ 6 };
+    int procs_per_app{ 2 };
+    int mem_mb{ 32 };
+    int cpu_duty{ 5 };
+    int switch_seconds{ 45 };
+    int screen_on_minutes{ 20 };
+    int screen_off_minutes{ 10 };
+    int respawn_seconds{ 30 };
+    int report_minutes{ 10 };
+    std::vector<std::string> daemon_args;
+};
+
+// 假应用：分配并触碰内存，以 100ms 为周期按占空比空转
+[[noreturn]] void runFakeApp(int mem_mb, int cpu_duty) {
+    std::vector<char> memory(static_cast<size_t>(mem_mb) << 20);
+    for (size_t i = 0; i < memory.size(); i += 4096) memory[i] = static_cast<char>(i);
+
+    const auto period = std::chrono::milliseconds(100);
+    const auto busy = period * std::clamp(cpu_duty, 0, 100) / 100;
+    volatile uint64_t sink = 0;
+    for (;;) {
+        auto start = Clock::now();
+        while (Clock::now() - start < busy) sink = sink + 1;
+        std::this_thread::sleep_until(start + period);
+    }
+}
+
+struct FakeProcess {
+    std::string package;
+    std::string name;
+    pid_t pid{ -1 };
+    Clock::time_point spawned_at{};
+    Clock::time_point died_at{};
+};
+
+struct DaemonSample {
+    double cpu_self_s{ 0 };
+    double cpu_children_s{ 0 };
+    long rss_kb{ 0 };
+    long hwm_kb{ 0 };
+    long ctx_voluntary{ 0 };
+    long ctx_involuntary{ 0 };
+    nlohmann::json status;
+};
+
+std::string readFile(const std::string& path) {
+    std::ifstream in(path);
+    std::stringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+void writeFile(const std::string& path, const std::string& content) {
+    std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::trunc);
+        out << content << '\n';
+    }
+    rename(tmp.c_str(), path.c_str());
+}
+
+long statusField(const std::string& status, const char* key) {
+    auto pos = status.find(key);
+    if (pos == std::string::npos) return 0;
+    return strtol(status.c_str() + pos + strlen(key), nullptr, 10);
+}
+
+class Harness {
+public:
+    explicit Harness(Options opts) : options(std::move(opts)) {
+        state_dir = options.workdir + "/state";
+        module_dir = options.workdir + "/module";
+    }
+
+    int run();
+
+private:
+    Options options;
+    std::string state_dir;
+    std::string module_dir;
+    pid_t daemon_pid{ -1 };
+    std::vector<FakeProcess> processes;
+    std::vector<std::string> packages;
+    size_t focus_index{ 0 };  // == packages.size() 表示桌面
+    bool screen_on{ true };
+    std::map<std::string, Clock::time_point> backgrounded_at;
+    std::vector<double> kill_latencies_s;
+    long kills{ 0 };
+    long foreground_kills{ 0 };
+
+    std::string focusPackage() const {
+        return focus_index < packages.size() ? packages[focus_index] : "com.android.launcher3";
+    }
+
+    pid_t spawnFakeApp(const std::string& name) {
+        pid_t parent = getpid();
+        pid_t pid = fork();
+        if (pid == 0) {
+            prctl(PR_SET_PDEATHSIG, SIGKILL);
+            if (getppid() != parent) _exit(0);
+            std::string mem = std::to_string(options.mem_mb);
+            std::string duty = std::to_string(options.cpu_duty);
+            // 守护进程按 cmdline 首段匹配进程名
+            char* argv[] = { const_cast<char*>(name.c_str()), const_cast<char*>("--fake-app"),
+                mem.data(), duty.data(), nullptr };
+            execv("/proc/self/exe", argv);
+            _exit(127);
+        }
+        return pid;
+    }
+
+    bool startDaemon() {
+        fs::create_directories(module_dir + "/logs");
+        fs::create_directories(module_dir + "/module_settings");
+        pid_t parent = getpid();
+        daemon_pid = fork();
+        if (daemon_pid < 0) return false;
+        if (daemon_pid == 0) {
+            prctl(PR_SET_PDEATHSIG, SIGTERM);
+            if (getppid() != parent) _exit(0);
+            std::string path = options.fixtures + ":" + (getenv("PATH") ? getenv("PATH") : "/usr/bin:/bin");
+            setenv("PATH", path.c_str(), 1);
+            setenv("SOAK_STATE", state_dir.c_str(), 1);
+
+            std::vector<std::string> args{ options.daemon, "--module-dir", module_dir,
+                "--packages-list", options.workdir + "/packages.list.missing" };
+            args.insert(args.end(), options.daemon_args.begin(), options.daemon_args.end());
+            for (const auto& package : packages) {
+                args.push_back(package);
+                for (int i = 0; i < options.procs_per_app; ++i) args.push_back(package + ":worker" + std::to_string(i));
+            }
+            std::vector<char*> argv;
+            for (auto& arg : args) argv.push_back(arg.data());
+            argv.push_back(nullptr);
+            execv(options.daemon.c_str(), argv.data());
+            _exit(127);
+        }
+        return true;
+    }
+
+    void writeState() {
+        writeFile(state_dir + "/focus", focusPackage());
+        writeFile(state_dir + "/screen", screen_on ? "ON" : "OFF");
+    }
+
+    // dumpsys meminfo 替身读取的各包 RSS 总和
+    void writeMeminfo() {
+        std::map<std::string, long> totals;
+        for (const auto& proc : processes) {
+            if (proc.pid <= 0) continue;
+            totals[proc.package] += statusField(readFile("/proc/" + std::to_string(proc.pid) + "/status"), "VmRSS:");
+        }
+        for (const auto& package : packages) writeFile(state_dir + "/meminfo/" + package, std::to_string(totals[package]));
+    }
+
+    void setFocus(size_t index, Clock::time_point now) {
+        std::string previous = focusPackage();
+        focus_index = index;
+        if (previous != focusPackage()) backgrounded_at[previous] = now;
+        writeState();
+    }
+
+    void reapChildren(Clock::time_point now) {
+        int status;
+        pid_t pid;
+        while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+            if (pid == daemon_pid) {
+                fprintf(stderr, "daemon exited (status %d)\n", status);
+                daemon_pid = -1;
+                g_stop = 1;
+                continue;
+            }
+            for (auto& proc : processes) {
+                if (proc.pid != pid) continue;
+                proc.pid = -1;
+                proc.died_at = now;
+                kills++;
+                if (screen_on && proc.package == focusPackage()) {
+                    foreground_kills++;
+                } else {
+                    // 从进入后台（或之后被拉起）到被杀的时间
+                    auto since = std::max(backgrounded_at[proc.package], proc.spawned_at);
+                    kill_latencies_s.push_back(std::chrono::duration<double>(now - since).count());
+                }
+            }
+        }
+    }
+
+    void respawn(Clock::time_point now) {
+        for (auto& proc : processes) {
+            if (proc.pid > 0 || now - proc.died_at < std::chrono::seconds(options.respawn_seconds)) continue;
+            proc.pid = spawnFakeApp(proc.name);
+            proc.spawned_at = now;
+        }
+    }
+
+    DaemonSample sampleDaemon() const {
+        DaemonSample sample;
+        std::string base = "/proc/" + std::to_string(daemon_pid);
+        std::string stat = readFile(base + "/stat");
+        auto close_paren = stat.rfind(')');
+        if (close_paren != std::string::npos) {
+            std::istringstream fields(stat.substr(close_paren + 2));
+            std::vector<std::string> f{ std::istream_iterator<std::string>(fields), {} };
+            // 字段从 state(3) 开始：utime=14 stime=15 cutime=16 cstime=17
+            if (f.size() > 14) {
+                double tick = static_cast<double>(sysconf(_SC_CLK_TCK));
+                sample.cpu_self_s = (std::stod(f[11]) + std::stod(f[12])) / tick;
+                sample.cpu_children_s = (std::stod(f[13]) + std::stod(f[14])) / tick;
+            }
+        }
+        std::string status = readFile(base + "/status");
+        sample.rss_kb = statusField(status, "VmRSS:");
+        sample.hwm_kb = statusField(status, "VmHWM:");
+
+        if (DIR* dir = opendir((base + "/task").c_str())) {
+            while (auto* entry = readdir(dir)) {
+                if (entry->d_name[0] == '.') continue;
+                std::string task_status = readFile(base + "/task/" + entry->d_name + "/status");
+                sample.ctx_voluntary += statusField(task_status, "voluntary_ctxt_switches:");
+                sample.ctx_involuntary += statusField(task_status, "nonvoluntary_ctxt_switches:");
+            }
+            closedir(dir);
+        }
+        sample.status = readStatusPage();
+        return sample;
+    }
+
+    // 通过守护进程自身的 --status 子命令读取状态页
+    nlohmann::json readStatusPage() const {
+        std::string cmd = options.daemon + " --status " + module_dir + "/logs/status.bin 2>/dev/null";
+        FILE* pipe = popen(cmd.c_str(), "r");
+        if (!pipe) return nullptr;
+        std::string output;
+        char buf[4096];
+        size_t n;
+        while ((n = fread(buf, 1, sizeof(buf), pipe)) > 0) output.append(buf, n);
+        pclose(pipe);
+        return nlohmann::json::parse(output, nullptr, false);
+    }
+
+    static double percentile(std::vector<double> values, double p) {
+        if (values.empty()) return 0;
+        std::sort(values.begin(), values.end());
+        size_t index = static_cast<size_t>(std::ceil(p * values.size())) - 1;
+        return values[std::min(index, values.size() - 1)];
+    }
+
+    nlohmann::json buildReport(const DaemonSample& sample, double elapsed_s) const {
+        auto statusValue = [&](const char* key) -> double {
+            if (!sample.status.is_object() || !sample.status.contains("stats")) return 0;
+            return sample.status["stats"].value(key, 0.0);
+        };
+        double hours = std::max(elapsed_s / 3600.0, 1e-9);
+        nlohmann::json j;
+        j["elapsed_s"] = elapsed_s;
+        j["daemon"] = {
+            { "cpu_self_s", sample.cpu_self_s },
+            { "cpu_children_s", sample.cpu_children_s },
+            { "cpu_self_s_per_hour", sample.cpu_self_s / hours },
+            { "cpu_children_s_per_hour", sample.cpu_children_s / hours },
+            { "rss_kb", sample.rss_kb },
+            { "hwm_kb", sample.hwm_kb },
+            { "ctx_voluntary", sample.ctx_voluntary },
+            { "ctx_involuntary", sample.ctx_involuntary },
+            { "ctx_per_hour", (sample.ctx_voluntary + sample.ctx_involuntary) / hours },
+            { "commands_spawned", statusValue("commands_spawned") },
+            { "commands_per_hour", statusValue("commands_spawned") / hours },
+            { "wakeups", statusValue("wakeups") },
+            { "wakeups_per_hour", statusValue("wakeups") / hours },
+        };
+        j["kills"] = {
+            { "total", kills },
+            { "while_foreground", foreground_kills },
+            { "latency_s", {
+                { "count", kill_latencies_s.size() },
+                { "min", kill_latencies_s.empty() ? 0 : *std::min_element(kill_latencies_s.begin(), kill_latencies_s.end()) },
+                { "median", percentile(kill_latencies_s, 0.5) },
+                { "p95", percentile(kill_latencies_s, 0.95) },
+                { "max", kill_latencies_s.empty() ? 0 : *std::max_element(kill_latencies_s.begin(), kill_latencies_s.end()) },
+            } },
+        };
+        j["status_page"] = sample.status;
+        return j;
+    }
+};
+
+int Harness::run() {
+    fs::create_directories(state_dir + "/meminfo");
+    for (int i = 0; i < options.apps; ++i) packages.push_back("com.soak.app" + std::to_string(i));
+
+    auto start = Clock::now();
+    setFocus(0, start);
+    for (const auto& package : packages) {
+        backgrounded_at[package] = start;
+        for (int i = 0; i < options.procs_per_app; ++i) {
+            FakeProcess proc;
+            proc.package = package;
+            proc.name = package + ":worker" + std::to_string(i);
+            proc.pid = spawnFakeApp(proc.name);
+            proc.spawned_at = start;
+            processes.push_back(proc);
+        }
+    }
+    writeMeminfo();
+
+    if (!startDaemon()) {
+        perror("fork");
+        return 1;
+    }
+    fprintf(stderr, "daemon pid %d, workdir %s\n", daemon_pid, options.workdir.c_str());
+
+    auto end = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::ratio<3600>>(options.hours));
+    auto next_switch = start + std::chrono::seconds(options.switch_seconds);
+    auto next_screen = start + std::chrono::minutes(options.screen_on_minutes);
+    auto next_meminfo = start + std::chrono::seconds(5);
+    auto next_report = start + std::chrono::minutes(options.report_minutes);
+
+    while (!g_stop && Clock::now() < end) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        auto now = Clock::now();
+        reapChildren(now);
+        respawn(now);
+
+        if (now >= next_switch) {
+            // 轮流切换前台应用，每轮回一次桌面
+            setFocus((focus_index + 1) % (packages.size() + 1), now);
+            next_switch = now + std::chrono::seconds(options.switch_seconds);
+        }
+        if (now >= next_screen) {
+            screen_on = !screen_on;
+            if (!screen_on) backgrounded_at[focusPackage()] = now;
+            writeState();
+            next_screen = now + std::chrono::minutes(screen_on ? options.screen_on_minutes : options.screen_off_minutes);
+        }
+        if (now >= next_meminfo) {
+            writeMeminfo();
+            next_meminfo = now + std::chrono::seconds(5);
+        }
+        if (now >= next_report && daemon_pid > 0) {
+            auto elapsed = std::chrono::duration<double>(now - start).count();
+            auto report = buildReport(sampleDaemon(), elapsed);
+            fprintf(stderr, "[%.0fs] cpu %.2fs rss %ldKB wakeups %.0f commands %.0f kills %ld\n", elapsed,
+                report["daemon"]["cpu_self_s"].get<double>(), report["daemon"]["rss_kb"].get<long>(),
+                report["daemon"]["wakeups"].get<double>(), report["daemon"]["commands_spawned"].get<double>(), kills);
+            next_report = now + std::chrono::minutes(options.report_minutes);
+        }
+    }
+
+    int exit_code = 0;
+    if (daemon_pid > 0) {
+        auto elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+        auto report = buildReport(sampleDaemon(), elapsed).dump(2);
+        printf("%s\n", report.c_str());
+        if (!options.report_path.empty()) writeFile(options.report_path, report);
+        kill(daemon_pid, SIGTERM);
+        waitpid(daemon_pid, nullptr, 0);
+    } else {
+        fprintf(stderr, "daemon did not survive the run\n");
+        exit_code = 1;
+    }
+    for (const auto& proc : processes) {
+        if (proc.pid > 0) kill(proc.pid, SIGKILL);
+    }
+    while (waitpid(-1, nullptr, 0) > 0) {}
+    return exit_code;
+}
+
+std::string defaultFixturesDir(const char* argv0) {
+    std::error_code ec;
+    auto self = fs::canonical("/proc/self/exe", ec);
+    for (auto dir : { self.parent_path() / "fixtures", fs::path(argv0).parent_path() / "fixtures",
+                      fs::path("tools/soak/fixtures") }) {
+        if (fs::exists(dir / "dumpsys", ec)) return fs::absolute(dir, ec).string();
+    }
+    return {};
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc >= 4 && strcmp(argv[1], "--fake-app") == 0) {
+        runFakeApp(atoi(argv[2]), atoi(argv[3]));
+    }
+
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto next = [&]() -> const char* { return i + 1 < argc ? argv[++i] : ""; };
+        if (arg == "--") {
+            options.daemon_args.assign(argv + i + 1, argv + argc);
+            break;
+        } else if (arg == "--daemon") options.daemon = next();
+        else if (arg == "--workdir") options.workdir = next();
+        else if (arg == "--fixtures") options.fixtures = next();
+        else if (arg == "--report") options.report_path = next();
+        else if (arg == "--hours") options.hours = atof(next());
+        else if (arg == "--apps") options.apps = atoi(next());
+        else if (arg == "--procs-per-app") options.procs_per_app = atoi(next());
+        else if (arg == "--mem-mb") options.mem_mb = atoi(next());
+        else if (arg == "--cpu-duty") options.cpu_duty = atoi(next());
+        else if (arg == "--switch-seconds") options.switch_seconds = atoi(next());
+        else if (arg == "--screen-on-minutes") options.screen_on_minutes = atoi(next());
+        else if (arg == "--screen-off-minutes") options.screen_off_minutes = atoi(next());
+        else if (arg == "--respawn-seconds") options.respawn_seconds = atoi(next());
+        else if (arg == "--report-minutes") options.report_minutes = atoi(next());
+        else {
+            fprintf(stderr, "Unknown option: %s\n", arg.c_str());
+            return 1;
+        }
+    }
+    if (options.daemon.empty() || options.apps <= 0 || options.procs_per_app <= 0) {
+        fprintf(stderr, "Usage: %s --daemon <process_manager> [--hours <h>] [--apps <n>] [--procs-per-app <n>] ... [-- <daemon args>]\n", argv[0]);
+        return 1;
+    }
+    if (options.fixtures.empty()) options.fixtures = defaultFixturesDir(argv[0]);
+    if (options.fixtures.empty()) {
+        fprintf(stderr, "Cannot locate fixtures directory, pass --fixtures\n");
+        return 1;
+    }
+    options.daemon = fs::absolute(options.daemon).string();
+    options.workdir = fs::absolute(options.workdir).string();
+
+    struct sigaction sa{};
+    sa.sa_handler = [](int) { g_stop = 1; };
+    sigaction(SIGINT, &sa, nullptr);
+    sigaction(SIGTERM, &sa, nullptr);
+
+    return Harness(std::move(options)).run();
+}
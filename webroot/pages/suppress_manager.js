@@ -11,10 +11,15 @@ const SuppressManagerPage = {
     isLoadingApps: false,
     searchQuery: '',
     selectedApp: null,
+    runtimeStatus: {},
+    statusTimer: null,
     
     // 配置项
     config: {
-        configPath: `${Core.MODULE_PATH}module_settings/suppress_config.json`
+        configPath: `${Core.MODULE_PATH}module_settings/suppress_config.json`,
+        // 守护进程通过 mmap 状态页发布实时状态，--status 只读取该文件，不会唤醒守护进程
+        statusCommand: `${Core.MODULE_PATH}bin/process_manager-DeepSuppressor --status ${Core.MODULE_PATH}logs/status.bin`,
+        statusRefreshInterval: 10000
     },
     
     // 预加载数据
@@ -22,9 +27,10 @@ const SuppressManagerPage = {
         try {
             // 预加载配置数据和应用列表
             const configData = await this.loadConfig();
+            const runtimeStatus = await this.loadStatus();
             // 开始加载应用列表，但不等待完成
             this.loadInstalledApps();
-            return { configData };
+            return { configData, runtimeStatus };
         } catch (error) {
             console.error('预加载抑制管理器数据失败:', error);
             return { configData: { suppress_apps: {} } };
@@ -42,9 +48,11 @@ const SuppressManagerPage = {
             
             if (preloadedData && preloadedData.configData) {
                 this.configData = preloadedData.configData;
+                this.runtimeStatus = preloadedData.runtimeStatus || {};
             } else {
-                // 加载配置
+                // 加载配置和运行状态
                 await this.loadConfig();
+                await this.loadStatus();
             }
             
             // 注册操作按钮和语言切换处理器
@@ -61,6 +69,53 @@ const SuppressManagerPage = {
         }
     },
     
+    // 读取守护进程状态页，按包名索引各目标的实时状态；守护进程未运行时为空
+    async loadStatus() {
+        try {
+            const output = await Core.execCommand(this.config.statusCommand);
+            const status = JSON.parse(output.trim());
+            const byPackage = {};
+            for (const target of status.targets || []) {
+                byPackage[target.package] = target;
+            }
+            this.runtimeStatus = status.running ? byPackage : {};
+        } catch (error) {
+            this.runtimeStatus = {};
+        }
+        return this.runtimeStatus;
+    },
+    
+    // 定期刷新状态，只更新已配置应用列表
+    async refreshStatus() {
+        await this.loadStatus();
+        const list = document.getElementById('configured-apps');
+        if (list) {
+            list.innerHTML = this.renderConfiguredApps();
+            this.bindConfiguredAppsEvents();
+        }
+    },
+    
+    // 渲染单个应用的运行状态行
+    renderRuntimeStatus(packageName) {
+        const status = this.runtimeStatus[packageName];
+        if (!status) return '';
+        
+        let state = status.foreground ?
+            I18n.translate('STATUS_FOREGROUND', '前台') :
+            I18n.translate('STATUS_BACKGROUND', '后台');
+        if (status.frozen) {
+            state += ` · ${I18n.translate('STATUS_FROZEN', '已冻结')}`;
+        }
+        const memoryMb = (status.memory_kb / 1024).toFixed(1);
+        return `
+            <div class="runtime-status">
+                ${state} · ${memoryMb}MB · CPU ${status.cpu_percent}% ·
+                ${I18n.translate('STATUS_KILLS', '杀死')} ${status.kills} ·
+                ${I18n.translate('STATUS_KILL_INTERVAL', '杀死间隔')} ${status.kill_interval_s}s
+            </div>
+        `;
+    },
+    
     // 加载配置
     async loadConfig() {
         try {
@@ -452,6 +507,7 @@ const SuppressManagerPage = {
                         <div class="app-name">${this.escapeHtml(packageName.split('.').pop() || packageName)}</div>
                         <div class="package-name">${this.escapeHtml(packageName)}</div>
                         <div class="process-count">${I18n.translate('PROCESSES', '进程')}: ${config.processes.length}</div>
+                        ${this.renderRuntimeStatus(packageName)}
                     </div>
                     <div class="app-actions">
                         <button class="icon-button edit-processes" data-package="${packageName}">
@@ -742,11 +798,18 @@ const SuppressManagerPage = {
     
     // 激活页面
     onActivate() {
-        // 页面激活时的处理
+        // 页面可见时定期刷新运行状态
+        this.refreshStatus();
+        this.statusTimer = setInterval(() => this.refreshStatus(), this.config.statusRefreshInterval);
     },
     
     // 停用页面
     onDeactivate() {
+        if (this.statusTimer) {
+            clearInterval(this.statusTimer);
+            this.statusTimer = null;
+        }
+        
         // 注销语言切换处理器
         I18n.unregisterLanguageChangeHandler(this.onLanguageChanged.bind(this));
         
@@ -788,6 +851,17 @@ const SuppressManagerPage = {
         }
         
         // 绑定已配置应用列表的事件
+        this.bindConfiguredAppsEvents();
+        
+        // 绑定添加应用对话框事件
+        this.bindAddAppDialogEvents();
+        
+        // 绑定编辑进程对话框事件
+        this.bindEditProcessesDialogEvents();
+    },
+    
+    // 绑定已配置应用列表事件
+    bindConfiguredAppsEvents() {
         const configuredAppsList = document.getElementById('configured-apps');
         if (configuredAppsList) {
             // 切换应用启用状态
@@ -820,12 +894,6 @@ const SuppressManagerPage = {
                 });
             });
         }
-        
-        // 绑定添加应用对话框事件
-        this.bindAddAppDialogEvents();
-        
-        // 绑定编辑进程对话框事件
-        this.bindEditProcessesDialogEvents();
     },
     
     // 绑定添加应用对话框事件